@@ -0,0 +1,175 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "fasta_loader.h"
+#include "median_string.h"
+#include "search_stats.h"
+
+using namespace std;
+
+
+namespace {
+
+int parseLength(const string& text, const string& spec) {
+    size_t used = 0;
+    int value = 0;
+    try {
+        value = stoi(text, &used);
+    } catch (const exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.length() || value < 1) {
+        throw invalid_argument("bad k-mer length spec '" + spec + "'");
+    }
+    if (value > MAX_KMER_LENGTH) {
+        throw invalid_argument("k-mer lengths go up to " + to_string(MAX_KMER_LENGTH));
+    }
+    return value;
+}
+
+
+// best of the eight one-nucleotide extensions of the K-1 median. a k-mer has the K-1
+// median as prefix or suffix, so this is usually at or near the optimum
+void seedFromShorter(const vector<PackedSequence>& sequences, int K, uint64_t shorter,
+                     uint64_t& seedKmer, int& seedDistance) {
+    seedDistance = INT_MAX;
+    for (uint64_t code = 0; code < 4; ++code) {
+        uint64_t candidates[2] = {shorter | (code << (2 * (K - 1))), (shorter << 2) | code};
+        for (uint64_t kmer : candidates) {
+            // a tie still needs its exact distance for the lexicographic tie break
+            int distance = distanceTotal(kmer, K, sequences, seedDistance == INT_MAX ? INT_MAX : seedDistance + 1);
+            if (distance < seedDistance || (distance == seedDistance && decodeKmer(kmer, K) < decodeKmer(seedKmer, K))) {
+                seedKmer = kmer;
+                seedDistance = distance;
+            }
+        }
+    }
+}
+
+}
+
+
+vector<int> parseKmerSpec(const string& spec) {
+    vector<int> lengths;
+    stringstream parts(spec);
+    string part;
+    while (getline(parts, part, ',')) {
+        size_t dash = part.find('-');
+        if (dash == string::npos) {
+            lengths.push_back(parseLength(part, spec));
+            continue;
+        }
+        int first = parseLength(part.substr(0, dash), spec);
+        int last = parseLength(part.substr(dash + 1), spec);
+        if (first > last) {
+            throw invalid_argument("bad k-mer length spec '" + spec + "'");
+        }
+        for (int K = first; K <= last; ++K) {
+            lengths.push_back(K);
+        }
+    }
+    if (lengths.empty()) {
+        throw invalid_argument("bad k-mer length spec '" + spec + "'");
+    }
+    sort(lengths.begin(), lengths.end());
+    lengths.erase(unique(lengths.begin(), lengths.end()), lengths.end());
+    return lengths;
+}
+
+
+vector<BatchJob> readManifest(const string& path, const vector<int>& defaultLengths) {
+    ifstream file(path);
+    if (!file) {
+        throw runtime_error("could not open manifest " + path);
+    }
+    vector<BatchJob> jobs;
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+        stringstream fields(line);
+        BatchJob job;
+        string spec;
+        if (!(fields >> job.path) || job.path[0] == '#') {
+            continue;
+        }
+        try {
+            job.kmerLengths = fields >> spec ? parseKmerSpec(spec) : defaultLengths;
+        } catch (const invalid_argument& e) {
+            throw runtime_error(path + ":" + to_string(lineNumber) + ": " + e.what());
+        }
+        if (job.kmerLengths.empty()) {
+            throw runtime_error(path + ":" + to_string(lineNumber) + ": no k-mer lengths for " + job.path);
+        }
+        jobs.push_back(move(job));
+    }
+    return jobs;
+}
+
+
+int runBatch(const vector<BatchJob>& jobs, const SearchSettings& settings, ostream& out) {
+    int failed = 0;
+    out << "file\tK\tengine\tmedian\tdistance\tseconds" << endl;
+
+    for (const auto& job : jobs) {
+        vector<PackedSequence> sequences;
+        STATS_ONLY(statsStartPhase("parse " + job.path);)
+        try {
+            sequences = loadFasta(job.path).sequences;
+            if (sequences.empty()) {
+                throw runtime_error("no sequences found in input file");
+            }
+        } catch (const exception& e) {
+            cerr << "Error: " << job.path << ": " << e.what() << "." << endl;
+            failed += job.kmerLengths.size();
+            continue;
+        }
+        size_t shortest = sequences.front().length;
+        for (const auto& seq : sequences) {
+            shortest = min(shortest, seq.length);
+        }
+
+        // result of the previous K, reused while the lengths stay consecutive
+        int previousK = 0;
+        uint64_t previousKmer = 0;
+        int previousDistance = 0;
+
+        for (int K : job.kmerLengths) {
+            if (static_cast<size_t>(K) > shortest) {
+                cerr << "Error: " << job.path << ": a sequence is shorter than k-mer length " << K << "." << endl;
+                failed++;
+                continue;
+            }
+
+            STATS_ONLY(statsStartPhase("solve " + job.path + " K=" + to_string(K));)
+            auto start = chrono::steady_clock::now();
+            uint64_t bestKmer = 0;
+            int bestDistance = INT_MAX;
+            int floor = 0;
+            // a K-mer's first K-1 positions are no further from any sequence than the whole
+            // K-mer, so the K-1 optimum is a lower bound here
+            if (previousK == K - 1) {
+                seedFromShorter(sequences, K, previousKmer, bestKmer, bestDistance);
+                floor = previousDistance;
+            }
+            solveMedian(sequences, K, settings, bestKmer, bestDistance, floor);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            out << job.path << '\t' << K << '\t' << resolveEngine(settings.engine, K, sequences.size()) << '\t' << decodeKmer(bestKmer, K)
+                << '\t' << bestDistance << '\t' << fixed << setprecision(3) << seconds << endl;
+
+            previousK = K;
+            previousKmer = bestKmer;
+            previousDistance = bestDistance;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,32 @@
+#ifndef MEDIAN_STRING_BATCH_H
+#define MEDIAN_STRING_BATCH_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "solver.h"
+
+
+// one input file and the k-mer lengths to solve it for
+struct BatchJob {
+    std::string path;
+    std::vector<int> kmerLengths;
+};
+
+// k-mer lengths from a spec such as "8", "5-9" or "5,7,10-12", sorted and without
+// duplicates. throws invalid_argument on a malformed spec
+std::vector<int> parseKmerSpec(const std::string& spec);
+
+// jobs from a manifest: one "<path> [k-spec]" per line, blank lines and lines starting with
+// '#' ignored. lines without a spec use defaultLengths. throws runtime_error if the manifest
+// cannot be read or a line has no k-mer lengths
+std::vector<BatchJob> readManifest(const std::string& path, const std::vector<int>& defaultLengths);
+
+// solve every job, parsing each file once and running its k-mer lengths in increasing order
+// against the same encoding. the median at K-1 seeds the K search and its distance is a
+// lower bound for it. writes a header and one tab separated row per (file, K) to out;
+// failures go to cerr. returns the number of failed jobs
+int runBatch(const std::vector<BatchJob>& jobs, const SearchSettings& settings, std::ostream& out);
+
+#endif
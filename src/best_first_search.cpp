@@ -0,0 +1,131 @@
+#include "best_first_search.h"
+
+#include <algorithm>
+#include <climits>
+#include <queue>
+#include <vector>
+
+#include "lower_bound.h"
+
+using namespace std;
+
+
+namespace {
+
+struct OpenPrefix {
+    uint64_t kmer;
+    int distance;   // of the prefix itself
+    int bound;      // distance raised by the configured bounds
+    int depth;
+};
+
+// packed k-mer with its first position in the high bits, so integer order is lexicographic
+inline uint64_t lexKey(uint64_t kmer) {
+    kmer = __builtin_bswap64(kmer);
+    kmer = (kmer & 0x0F0F0F0F0F0F0F0FULL) << 4 | (kmer >> 4 & 0x0F0F0F0F0F0F0F0FULL);
+    return (kmer & 0x3333333333333333ULL) << 2 | (kmer >> 2 & 0x3333333333333333ULL);
+}
+
+// lowest bound on top; among equal bounds the deeper prefix, which is closer to a leaf, then
+// the lexicographically first, which keeps consecutive prefixes sharing most of their rows
+struct ExpandLater {
+    bool operator()(const OpenPrefix& a, const OpenPrefix& b) const {
+        if (a.bound != b.bound) {
+            return a.bound > b.bound;
+        }
+        if (a.depth != b.depth) {
+            return a.depth < b.depth;
+        }
+        return lexKey(a.kmer) > lexKey(b.kmer);
+    }
+};
+
+
+// rows of state hold the prefix path of length pathDepth. bring them to the prefix of node,
+// replaying only the positions past the part both share
+void replayPrefix(const WindowIndex& index, PrefixState& state, uint64_t& path, int& pathDepth,
+                  const OpenPrefix& node, WorkerStats* stats) {
+    int shared = 0;
+    int limit = min(pathDepth, node.depth);
+    while (shared < limit && ((path ^ node.kmer) >> (2 * shared) & 3) == 0) {
+        shared++;
+    }
+    for (int iter = shared; iter < node.depth; ++iter) {
+        extendPrefix(index, state, iter, (node.kmer >> (2 * iter)) & 3, INT_MAX, stats);
+    }
+    path = node.kmer;
+    pathDepth = node.depth;
+}
+
+}
+
+
+void best_first_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, size_t queueBytes,
+                       int floor, const BoundSet* bounds) {
+    int K = index.K;
+    PrefixState state = makePrefixState(index);
+    SharedIncumbent incumbent(1, bestKmer, bestDistance, floor);
+    STATS_ONLY(SearchStats stats("bestfirst", K, 1);)
+    STATS_ONLY(if (bounds) stats.setBounds(bounds->names());)
+    STATS_ONLY(incumbent.stats = &stats;)
+    WorkerStats* counters = nullptr;
+    STATS_ONLY(counters = &stats.worker(0);)
+
+    priority_queue<OpenPrefix, vector<OpenPrefix>, ExpandLater> open;
+    size_t capacity = max<size_t>(queueBytes / sizeof(OpenPrefix), 1);
+    // the last level is cheaper to finish than to queue, so are the tail solved ones
+    int dfsDepth = K - max(index.tailLength, 1);
+    uint64_t path = 0;
+    int pathDepth = 0;
+
+    open.push({0, 0, 0, 0});
+    while (!open.empty()) {
+        OpenPrefix node = open.top();
+        open.pop();
+        // every open prefix is at least as far as this one
+        int bound = incumbent.bound();
+        if (node.bound >= bound || bound <= incumbent.floor()) {
+            break;
+        }
+        replayPrefix(index, state, path, pathDepth, node, counters);
+
+        if (node.depth >= dfsDepth) {
+            uint64_t kmer = node.kmer;
+            branch_and_bound(index, state, kmer, incumbent, bounds, 0, node.depth, node.distance);
+            continue;
+        }
+        STATS_ONLY(counters->nodes[node.depth]++;)
+
+        int distances[4];
+        scoreChildren(index, state, node.depth, distances, incumbent.bound(), counters);
+        for (int code = 0; code < 4; ++code) {
+            uint64_t kmer = node.kmer | static_cast<uint64_t>(code) << (2 * node.depth);
+            int distance = distances[code];
+            if (distance >= incumbent.bound()) {
+                STATS_ONLY(counters->nodes[node.depth + 1]++;)
+                STATS_ONLY(counters->pruned[node.depth + 1]++;)
+                continue;
+            }
+            if (open.size() >= capacity) {
+                // queue full: search this subtree depth-first right away
+                extendPrefix(index, state, node.depth, code, INT_MAX, counters);
+                branch_and_bound(index, state, kmer, incumbent, bounds, 0, node.depth + 1, distance);
+                continue;
+            }
+            int childBound = distance;
+            if (bounds) {
+                extendPrefix(index, state, node.depth, code, INT_MAX, counters);
+                childBound = bounds->evaluate(index, state, node.depth + 1, distance, incumbent.bound(), counters);
+                if (childBound >= incumbent.bound()) {
+                    STATS_ONLY(counters->nodes[node.depth + 1]++;)
+                    STATS_ONLY(counters->pruned[node.depth + 1]++;)
+                    continue;
+                }
+            }
+            open.push({kmer, distance, childBound, node.depth + 1});
+        }
+    }
+
+    bestDistance = incumbent.best(bestKmer, K);
+    STATS_ONLY(stats.finish(bestDistance);)
+}
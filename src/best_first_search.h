@@ -0,0 +1,21 @@
+#ifndef MEDIAN_STRING_BEST_FIRST_SEARCH_H
+#define MEDIAN_STRING_BEST_FIRST_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "search.h"
+
+
+// default ceiling on the open list of best_first_search, in megabytes
+const int DEFAULT_QUEUE_MB = 256;
+
+// best-first branch and bound. open prefixes wait in a priority queue ordered by their lower
+// bound and the lowest one is always expanded next, so the search is over as soon as that
+// bound reaches the incumbent. the queue holds at most queueBytes worth of prefixes; a child
+// that does not fit is searched depth-first on the spot, as are prefixes close enough to the
+// leaves for the tail solve. bestKmer/bestDistance, floor and bounds as for branch_and_bound
+void best_first_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, size_t queueBytes,
+                       int floor = 0, const BoundSet* bounds = nullptr);
+
+#endif
@@ -0,0 +1,287 @@
+#include "bitslice_search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "search_stats.h"
+
+using namespace std;
+
+
+namespace {
+
+// 64-window words scored between checks for an early exit
+const size_t EXIT_CHECK_WORDS = 16;
+
+// widest counter the search needs: counts go up to K <= MAX_KMER_LENGTH
+const int MAX_COUNTER_BITS = 6;
+
+struct BitSlices {
+    size_t totalWords = 0;
+    vector<size_t> words;     // 64-window words per sequence
+    vector<size_t> offsets;   // first word of each sequence within a bitset
+    // bit w % 64 of word offsets[s] + w / 64 is set when window w of sequence s has code c at
+    // position j. padding past the last window and non-ACGT codes match nothing, so a padding
+    // window's count is the depth, never below the count of a real window
+    vector<uint64_t> matches;
+
+    const uint64_t* match(int j, int c) const { return matches.data() + (4 * j + c) * totalWords; }
+};
+
+// the vertical counters of the current path. row d holds the mismatches of every window
+// against the first d prefix positions: sequence s from word offsets[s] * bits, bit b of its
+// counts in the words[s] words from b * words[s] on
+struct SliceState {
+    vector<vector<uint64_t>> counters;
+    PrefixState bytes;                 // byte row for solveTail, see unpackSlices
+    vector<vector<int>> minima;        // per depth and sequence
+    vector<vector<int>> childMinima;   // per depth, 4 * s + code for each child of the node
+};
+
+
+BitSlices sliceIndex(const WindowIndex& index) {
+    BitSlices slices;
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        slices.offsets.push_back(slices.totalWords);
+        slices.words.push_back((index.windows[s] + 63) / 64);
+        slices.totalWords += slices.words.back();
+    }
+    slices.matches.assign(4 * index.K * slices.totalWords, 0);
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        for (int j = 0; j < index.K; ++j) {
+            const uint8_t* nt = index.plane(s, j);
+            for (size_t w = 0; w < index.windows[s]; ++w) {
+                if (nt[w] < 4) {
+                    slices.matches[(4 * j + nt[w]) * slices.totalWords + slices.offsets[s] + w / 64] |= 1ULL << (w % 64);
+                }
+            }
+        }
+    }
+    return slices;
+}
+
+
+// distance of each of the four children of the prefix in row iter, and their per-sequence
+// minima in childMinima[iter]. a window is at a child's minimum only if it is at the
+// parent's and matches the child's code; if no window is, every window is one above.
+// stops once every distance reaches limit, leaving the other minima unset
+template <int BITS>
+void scoreSlices(const WindowIndex& index, const BitSlices& slices, SliceState& state, int iter, int distances[4],
+                 int limit, WorkerStats* stats) {
+    fill(distances, distances + 4, 0);
+    const uint64_t* row = state.counters[iter].data();
+    int* childMinima = state.childMinima[iter].data();
+    for (size_t s = 0; s < slices.words.size(); ++s) {
+        size_t words = slices.words[s];
+        const uint64_t* in = row + slices.offsets[s] * BITS;
+        const uint64_t* h0 = slices.match(iter, 0) + slices.offsets[s];
+        const uint64_t* h1 = slices.match(iter, 1) + slices.offsets[s];
+        const uint64_t* h2 = slices.match(iter, 2) + slices.offsets[s];
+        const uint64_t* h3 = slices.match(iter, 3) + slices.offsets[s];
+        int minimum = state.minima[iter][s];
+        uint64_t pattern[BITS];
+        for (int b = 0; b < BITS; ++b) {
+            pattern[b] = (minimum >> b & 1) ? ~0ULL : 0;
+        }
+        uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+        size_t end = 0;
+        while (end < words) {
+            size_t begin = end;
+            end = min(words, begin + EXIT_CHECK_WORDS);
+            for (size_t i = begin; i < end; ++i) {
+                uint64_t atMinimum = ~0ULL;
+                for (int b = 0; b < BITS; ++b) {
+                    atMinimum &= ~(in[b * words + i] ^ pattern[b]);
+                }
+                a0 |= atMinimum & h0[i];
+                a1 |= atMinimum & h1[i];
+                a2 |= atMinimum & h2[i];
+                a3 |= atMinimum & h3[i];
+            }
+            if (a0 && a1 && a2 && a3) {
+                break;
+            }
+        }
+        int* mins = childMinima + 4 * s;
+        mins[0] = minimum + (a0 == 0);
+        mins[1] = minimum + (a1 == 0);
+        mins[2] = minimum + (a2 == 0);
+        mins[3] = minimum + (a3 == 0);
+        for (int c = 0; c < 4; ++c) {
+            distances[c] += mins[c];
+        }
+        if (stats) {
+            stats->windows += min(end * 64, index.windows[s]);
+        }
+        if (min(min(distances[0], distances[1]), min(distances[2], distances[3])) >= limit) {
+            return;
+        }
+    }
+}
+
+
+// fill row iter+1 from row iter with code placed at prefix position iter: the mismatch
+// bitset is added into the counters with a ripple carry. the minima come from scoreSlices
+template <int BITS>
+void extendSlices(const WindowIndex& index, const BitSlices& slices, SliceState& state, int iter, int code,
+                  WorkerStats* stats) {
+    const uint64_t* parent = state.counters[iter].data();
+    uint64_t* child = state.counters[iter + 1].data();
+    for (size_t s = 0; s < slices.words.size(); ++s) {
+        size_t words = slices.words[s];
+        const uint64_t* in = parent + slices.offsets[s] * BITS;
+        uint64_t* out = child + slices.offsets[s] * BITS;
+        const uint64_t* hit = slices.match(iter, code) + slices.offsets[s];
+        for (size_t i = 0; i < words; ++i) {
+            uint64_t carry = ~hit[i];
+            for (int b = 0; b < BITS; ++b) {
+                uint64_t bit = in[b * words + i];
+                out[b * words + i] = bit ^ carry;
+                carry &= bit;
+            }
+        }
+        state.minima[iter + 1][s] = state.childMinima[iter][4 * s + code];
+        if (stats) {
+            stats->windows += index.windows[s];
+        }
+    }
+}
+
+
+// byte k of spreadBits(x) is bit k of x
+struct SpreadTable {
+    uint64_t bytes[256];
+    SpreadTable() {
+        for (int x = 0; x < 256; ++x) {
+            bytes[x] = 0;
+            for (int k = 0; k < 8; ++k) {
+                bytes[x] |= static_cast<uint64_t>(x >> k & 1) << (8 * k);
+            }
+        }
+    }
+};
+
+const SpreadTable spreadBits;
+
+
+// copy the counts of sequence s in row iter into row iter of the byte state, so solveTail can
+// read them. eight windows at a time: each counter bit is spread to one bit per byte and
+// shifted into place
+template <int BITS>
+void unpackSlices(const WindowIndex& index, const BitSlices& slices, SliceState& state, int iter, size_t s) {
+    size_t words = slices.words[s];
+    const uint64_t* in = state.counters[iter].data() + slices.offsets[s] * BITS;
+    uint8_t* out = state.bytes.depthCounts[iter].data() + index.offsets[s];
+    size_t windows = index.windows[s];
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t counts[8] = {};
+        for (int b = 0; b < BITS; ++b) {
+            uint64_t bit = in[b * words + i];
+            for (int k = 0; k < 8; ++k) {
+                counts[k] |= spreadBits.bytes[bit >> (8 * k) & 0xFF] << b;
+            }
+        }
+        memcpy(out + 64 * i, counts, min<size_t>(64, windows - 64 * i));
+    }
+}
+
+
+template <int BITS>
+void searchSlices(const WindowIndex& index, const BitSlices& slices, SliceState& state, SharedIncumbent& incumbent,
+                  WorkerStats* stats, int iter, uint64_t kmer) {
+    STATS_ONLY(stats->nodes[iter]++;)
+    int bound = incumbent.bound();
+    if (bound <= incumbent.floor()) {
+        STATS_ONLY(stats->pruned[iter]++;)
+        return;
+    }
+
+    // close enough to the leaves to finish the whole subtree at once
+    if (iter == index.K - index.tailLength) {
+        // solveTail may rule the prefix out before it reads every sequence
+        uint64_t tail = 0;
+        int distance = solveTail(index, state.bytes, iter, bound, tail, stats,
+                                 [&](size_t s) { unpackSlices<BITS>(index, slices, state, iter, s); });
+        if (distance < bound) {
+            uint64_t best = kmer | (tail << (2 * iter));
+            incumbent.offer(0, best, distance);
+        }
+        return;
+    }
+
+    int distances[4];
+    scoreSlices<BITS>(index, slices, state, iter, distances, bound, stats);
+    // closest first; insertion sort keeps the configured order among equal distances
+    const uint8_t* codes = index.childOrder.codes;
+    int order[4] = {codes[0], codes[1], codes[2], codes[3]};
+    for (int i = 1; i < 4; ++i) {
+        for (int j = i; j > 0 && distances[order[j]] < distances[order[j - 1]]; --j) {
+            swap(order[j], order[j - 1]);
+        }
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        int code = order[i];
+        int distance = distances[code];
+        if (distance >= incumbent.bound()) {
+            STATS_ONLY(stats->nodes[iter + 1] += 4 - i;)
+            STATS_ONLY(stats->pruned[iter + 1] += 4 - i;)
+            break;
+        }
+        uint64_t child = kmer | static_cast<uint64_t>(code) << (2 * iter);
+        // the children of the last inner level are leaves, already scored exactly
+        if (iter + 1 == index.K) {
+            STATS_ONLY(stats->nodes[iter + 1]++;)
+            incumbent.offer(0, child, distance);
+            continue;
+        }
+        extendSlices<BITS>(index, slices, state, iter, code, stats);
+        searchSlices<BITS>(index, slices, state, incumbent, stats, iter + 1, child);
+    }
+}
+
+
+template <int BITS>
+void searchFromRoot(const WindowIndex& index, const BitSlices& slices, SharedIncumbent& incumbent, WorkerStats* stats) {
+    size_t sequences = slices.words.size();
+    SliceState state;
+    // row 0 is the empty prefix: every counter at 0
+    state.counters.assign(index.K, vector<uint64_t>(slices.totalWords * BITS, 0));
+    state.minima.assign(index.K, vector<int>(sequences, 0));
+    state.childMinima.assign(index.K, vector<int>(4 * sequences, 0));
+    if (index.tailLength > 0) {
+        state.bytes = makePrefixState(index);
+    }
+    searchSlices<BITS>(index, slices, state, incumbent, stats, 0, 0);
+}
+
+
+using SliceSearch = void (*)(const WindowIndex&, const BitSlices&, SharedIncumbent&, WorkerStats*);
+
+template <size_t... Bits>
+SliceSearch searchForBits(int bits, index_sequence<Bits...>) {
+    static const SliceSearch table[] = {searchFromRoot<Bits + 1>...};
+    return table[bits - 1];
+}
+
+}
+
+
+void bitslice_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, int floor) {
+    int K = index.K;
+    BitSlices slices = sliceIndex(index);
+    SharedIncumbent incumbent(1, bestKmer, bestDistance, floor);
+    STATS_ONLY(SearchStats stats("bitslice", K, 1);)
+    STATS_ONLY(incumbent.stats = &stats;)
+    WorkerStats* counters = nullptr;
+    STATS_ONLY(counters = &stats.worker(0);)
+
+    // counters just wide enough for a count of K
+    int bits = 32 - __builtin_clz(static_cast<unsigned>(K));
+    searchForBits(bits, make_index_sequence<MAX_COUNTER_BITS>())(index, slices, incumbent, counters);
+
+    bestDistance = incumbent.best(bestKmer, K);
+    STATS_ONLY(stats.finish(bestDistance);)
+}
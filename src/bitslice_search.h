@@ -0,0 +1,22 @@
+#ifndef MEDIAN_STRING_BITSLICE_SEARCH_H
+#define MEDIAN_STRING_BITSLICE_SEARCH_H
+
+#include <cstdint>
+
+#include "search.h"
+
+
+// depth-first branch and bound over a bit-sliced copy of index. every sequence is transposed
+// into one bitset per position and nucleotide over its window starts, and a window's mismatch
+// count is held as vertical counters, bit b of every count in one bitset per depth. extending
+// a prefix is then a ripple-carry add of a mismatch bitset into the counters, 64 windows per
+// word. a child's minimum is the parent's or one above, so scoring all four children of a
+// node only asks whether any window at the parent's minimum matches each code, an equality
+// test against the counter bits. the leaves are scored that way from their parent too, unless
+// index has a tail solve: its prefixes are unpacked into a byte row for solveTail. children
+// are always visited closest first, ties in the configured child order, and the extra lower
+// bounds do not apply.
+// bestKmer/bestDistance and floor as for branch_and_bound
+void bitslice_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, int floor = 0);
+
+#endif
@@ -0,0 +1,78 @@
+#include "exhaustive_search.h"
+
+#include <algorithm>
+
+#include "search_stats.h"
+
+using namespace std;
+
+
+void gray_code_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance) {
+    int K = index.K;
+    // every k-mer is a leaf visit; the tree above it is never walked
+    STATS_ONLY(SearchStats stats("gray", K, 1);)
+    STATS_ONLY(WorkerStats& counters = stats.worker(0);)
+
+    // start at AAA...A: a window's count is its number of non-A positions
+    vector<uint8_t> counts(index.totalWindows, 0);
+    uint64_t kmer = 0;
+    int distance = 0;
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        uint8_t* count = counts.data() + index.offsets[s];
+        for (int j = 0; j < K; ++j) {
+            const uint8_t* nt = index.plane(s, j);
+            for (size_t w = 0; w < index.windows[s]; ++w) {
+                count[w] += nt[w] != 0;
+            }
+        }
+        uint8_t minCount = UINT8_MAX;
+        for (size_t w = 0; w < index.windows[s]; ++w) {
+            minCount = min(minCount, count[w]);
+        }
+        distance += minCount;
+    }
+    STATS_ONLY(counters.windows += index.totalWindows * K;)
+    if (distance < bestDistance) {
+        STATS_ONLY(stats.improvement(0, kmer, distance);)
+        bestDistance = distance;
+        bestKmer = kmer;
+    }
+
+    // digit i moves whenever i is the number of trailing base-4 zeros of the step counter,
+    // sweeping 0..3 and back; that is the reflected Gray code
+    vector<int> digit(K, 0);
+    vector<int> dir(K, 1);
+    uint64_t total = 1ULL << (2 * K);
+    for (uint64_t step = 1; step < total; ++step) {
+        int pos = __builtin_ctzll(step) / 2;
+        uint8_t from = static_cast<uint8_t>(digit[pos]);
+        digit[pos] += dir[pos];
+        if (digit[pos] == 0 || digit[pos] == 3) {
+            dir[pos] = -dir[pos];
+        }
+        uint8_t to = static_cast<uint8_t>(digit[pos]);
+        kmer = (kmer & ~(3ULL << (2 * pos))) | (static_cast<uint64_t>(to) << (2 * pos));
+
+        distance = 0;
+        for (size_t s = 0; s < index.codes.size(); ++s) {
+            const uint8_t* nt = index.plane(s, pos);
+            uint8_t* count = counts.data() + index.offsets[s];
+            size_t windows = index.windows[s];
+            uint8_t minCount = UINT8_MAX;
+            for (size_t w = 0; w < windows; ++w) {
+                uint8_t c = count[w] + (nt[w] == from) - (nt[w] == to);
+                count[w] = c;
+                minCount = min(minCount, c);
+            }
+            distance += minCount;
+        }
+        if (distance < bestDistance) {
+            STATS_ONLY(stats.improvement(0, kmer, distance);)
+            bestDistance = distance;
+            bestKmer = kmer;
+        }
+    }
+    STATS_ONLY(counters.nodes[K] = total;)
+    STATS_ONLY(counters.windows += index.totalWindows * (total - 1);)
+    STATS_ONLY(stats.finish(bestDistance);)
+}
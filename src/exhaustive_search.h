@@ -0,0 +1,18 @@
+#ifndef MEDIAN_STRING_EXHAUSTIVE_SEARCH_H
+#define MEDIAN_STRING_EXHAUSTIVE_SEARCH_H
+
+#include <cstdint>
+
+#include "search.h"
+
+
+// largest K the exhaustive engines accept; 4^K k-mers are visited one by one
+const int MAX_GRAY_K = 12;
+
+// score all 4^K k-mers in reflected base-4 Gray code order. consecutive k-mers differ in
+// one position, so every window's mismatch count is patched with a single compare instead
+// of being recounted. no pruning and no recursion: the cost is exactly 4^K window passes.
+// bestKmer/bestDistance carry a starting incumbent in (kept on ties) and the optimum out
+void gray_code_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance);
+
+#endif
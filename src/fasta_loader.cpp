@@ -0,0 +1,235 @@
+#include "fasta_loader.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+namespace {
+
+// bytes read per call when streaming
+const size_t STREAM_CHUNK = 1 << 20;
+
+// owns a read-only mapping (or a heap copy when mapping is not possible)
+class FileImage {
+public:
+    explicit FileImage(const string& path) {
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("unable to open input file");
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            size = static_cast<size_t>(st.st_size);
+            if (size == 0) {
+                return;
+            }
+            void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                mapped = static_cast<const char*>(addr);
+                madvise(addr, size, MADV_SEQUENTIAL);
+                return;
+            }
+        }
+        // a constructor that throws gets no destructor call
+        try {
+            readAll();
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+
+    ~FileImage() {
+        if (mapped) {
+            munmap(const_cast<char*>(mapped), size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    FileImage(const FileImage&) = delete;
+    FileImage& operator=(const FileImage&) = delete;
+
+    const char* data() const { return mapped ? mapped : buffer.data(); }
+    size_t length() const { return mapped ? size : buffer.size(); }
+
+private:
+    void readAll() {
+        char chunk[1 << 16];
+        ssize_t got;
+        while ((got = read(fd, chunk, sizeof(chunk))) > 0) {
+            buffer.insert(buffer.end(), chunk, chunk + got);
+        }
+        if (got < 0) {
+            throw runtime_error("unable to read input file");
+        }
+    }
+
+    int fd = -1;
+    const char* mapped = nullptr;
+    size_t size = 0;
+    vector<char> buffer;
+};
+
+
+// splits fasta text into records for a sink. input may arrive in arbitrary pieces, so a
+// line (header or sequence) can straddle two feed calls
+class FastaScanner {
+public:
+    explicit FastaScanner(FastaSink& sink) : sink(sink) {}
+
+    void feed(const char* data, size_t size) {
+        const char* p = data;
+        const char* end = data + size;
+        while (p < end) {
+            if (lineStart) {
+                lineStart = false;
+                if (*p == '>') {
+                    if (inRecord) {
+                        sink.endRecord();
+                        inRecord = false;
+                    }
+                    inHeader = true;
+                    header.clear();
+                    p++;
+                    continue;
+                }
+                // sequence text before the first header forms an unnamed record, as before
+                if (!inHeader && !inRecord) {
+                    sink.beginRecord("");
+                    inRecord = true;
+                }
+            }
+
+            const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+            const char* segmentEnd = eol ? eol : end;
+            if (inHeader) {
+                header.append(p, segmentEnd);
+            } else {
+                // drop the CR of CRLF endings, even when the LF only comes with the next piece
+                const char* textEnd = segmentEnd;
+                if (textEnd > p && textEnd[-1] == '\r') {
+                    textEnd--;
+                }
+                if (textEnd > p) {
+                    sink.appendSequence(p, textEnd - p);
+                }
+            }
+
+            if (!eol) {
+                return;
+            }
+            if (inHeader) {
+                finishHeader();
+            }
+            lineStart = true;
+            p = eol + 1;
+        }
+    }
+
+    void finish() {
+        if (inHeader) {
+            finishHeader();
+        }
+        if (inRecord) {
+            sink.endRecord();
+            inRecord = false;
+        }
+    }
+
+private:
+    void finishHeader() {
+        if (!header.empty() && header.back() == '\r') {
+            header.pop_back();
+        }
+        sink.beginRecord(header);
+        inHeader = false;
+        inRecord = true;
+    }
+
+    FastaSink& sink;
+    bool lineStart = true;
+    bool inHeader = false;
+    bool inRecord = false;
+    string header;
+};
+
+
+// collects records into the packed store
+class PackedSink : public FastaSink {
+public:
+    explicit PackedSink(FastaFile& fasta) : fasta(fasta) {}
+
+    void beginRecord(const string& recordName) override {
+        name = recordName;
+        current = PackedSequence();
+    }
+
+    void appendSequence(const char* data, size_t n) override {
+        ::appendSequence(current, data, n);
+    }
+
+    void endRecord() override {
+        // as before, a header with no sequence lines does not produce a record
+        if (current.length > 0) {
+            fasta.names.push_back(name);
+            fasta.sequences.push_back(move(current));
+        }
+    }
+
+private:
+    FastaFile& fasta;
+    PackedSequence current;
+    string name;
+};
+
+}
+
+
+FastaFile parseFasta(const char* data, size_t size) {
+    FastaFile fasta;
+    PackedSink sink(fasta);
+    FastaScanner scanner(sink);
+    scanner.feed(data, size);
+    scanner.finish();
+    return fasta;
+}
+
+
+FastaFile loadFasta(const string& path) {
+    FileImage image(path);
+    return parseFasta(image.data(), image.length());
+}
+
+
+void streamFasta(const string& path, FastaSink& sink) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("unable to open input file");
+    }
+    // the sink may throw; the descriptor must not outlive this call either way
+    struct Closer {
+        int fd;
+        ~Closer() { close(fd); }
+    } closer{fd};
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    FastaScanner scanner(sink);
+    vector<char> chunk(STREAM_CHUNK);
+    ssize_t got;
+    while ((got = read(fd, chunk.data(), chunk.size())) > 0) {
+        scanner.feed(chunk.data(), static_cast<size_t>(got));
+    }
+    if (got < 0) {
+        throw runtime_error("unable to read input file");
+    }
+    scanner.finish();
+}
@@ -0,0 +1,41 @@
+#ifndef MEDIAN_STRING_FASTA_LOADER_H
+#define MEDIAN_STRING_FASTA_LOADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "packed_sequence.h"
+
+
+// records of a multi-fasta file, encoded straight into the packed store.
+// records without any sequence lines are dropped
+struct FastaFile {
+    std::vector<std::string> names;
+    std::vector<PackedSequence> sequences;
+};
+
+// map the file read-only and encode each sequence line in place, with no intermediate
+// strings. falls back to a buffered read when the file cannot be mapped (pipes, etc).
+// throws runtime_error if the file cannot be read
+FastaFile loadFasta(const std::string& path);
+
+// parse an in-memory fasta image; loadFasta runs this over the mapping
+FastaFile parseFasta(const char* data, size_t size);
+
+
+// receives a fasta file record by record. sequence text arrives in pieces with line breaks
+// removed; a record may get any number of pieces, including none
+class FastaSink {
+public:
+    virtual ~FastaSink() = default;
+    virtual void beginRecord(const std::string& name) = 0;
+    virtual void appendSequence(const char* data, size_t n) = 0;
+    virtual void endRecord() = 0;
+};
+
+// read the file through a fixed-size buffer and feed it to sink, so memory use does not
+// depend on the size of the file or of any record. throws runtime_error on read failure
+void streamFasta(const std::string& path, FastaSink& sink);
+
+#endif
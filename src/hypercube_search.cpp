@@ -0,0 +1,160 @@
+#include "hypercube_search.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "search_stats.h"
+
+using namespace std;
+
+
+namespace {
+
+// windows with more unknown positions than this are checked directly instead of being
+// expanded into every substitution
+const int MAX_EXPANDED_INVALID = 3;
+
+struct DeferredWindow {
+    uint64_t kmer;
+    uint64_t invalid;
+};
+
+// mark every ACGT substitution of the invalid positions of a window with its invalid count
+void markSubstitutions(vector<uint8_t>& dist, uint64_t kmer, uint64_t invalid, int count) {
+    vector<int> positions;
+    for (int j = 0; invalid >> (2 * j); ++j) {
+        if ((invalid >> (2 * j)) & 1) {
+            positions.push_back(j);
+        }
+    }
+    for (uint64_t sub = 0; sub < (1ULL << (2 * positions.size())); ++sub) {
+        uint64_t x = kmer;
+        for (size_t p = 0; p < positions.size(); ++p) {
+            x |= ((sub >> (2 * p)) & 3) << (2 * positions[p]);
+        }
+        dist[x] = min<uint8_t>(dist[x], count);
+    }
+}
+
+// lexicographic rank of a packed k-mer: its first nucleotide becomes the most significant digit
+uint64_t lexicalKey(uint64_t kmer, int K) {
+    uint64_t key = 0;
+    for (int j = 0; j < K; ++j) {
+        key = (key << 2) | ((kmer >> (2 * j)) & 3);
+    }
+    return key;
+}
+
+}
+
+
+vector<uint8_t> distanceTransform(const PackedSequence& seq, int K) {
+    return distanceTransform(summarizeSequence(seq, K));
+}
+
+
+vector<uint8_t> distanceTransform(const KmerSummary& summary) {
+    int K = summary.K;
+    size_t size = 1ULL << (2 * K);
+    // no k-mer is ever further than K from a window
+    vector<uint8_t> dist(size, static_cast<uint8_t>(K));
+
+    for (size_t w = 0; w < summary.presence.size(); ++w) {
+        for (uint64_t bits = summary.presence[w]; bits; bits &= bits - 1) {
+            dist[w * 64 + __builtin_ctzll(bits)] = 0;
+        }
+    }
+
+    // non-ACGT positions mismatch every k-mer, so such a window sits at its invalid
+    // count from each of its ACGT substitutions
+    vector<DeferredWindow> deferred;
+    int deferredMin = K;
+    for (const auto& window : summary.invalidWindows) {
+        int count = __builtin_popcountll(window.second);
+        if (count <= MAX_EXPANDED_INVALID) {
+            markSubstitutions(dist, window.first, window.second, count);
+        } else if (count < K) {
+            deferred.push_back({window.first, window.second});
+            deferredMin = min(deferredMin, count);
+        }
+    }
+
+    // Hamming distance is a sum over positions, so relaxing one axis at a time is exact:
+    // along axis j each group of four k-mers differing only there takes min(own, group + 1)
+    for (int j = 0; j < K; ++j) {
+        size_t stride = 1ULL << (2 * j);
+        for (size_t base = 0; base < size; base += 4 * stride) {
+            uint8_t* v0 = dist.data() + base;
+            uint8_t* v1 = v0 + stride;
+            uint8_t* v2 = v1 + stride;
+            uint8_t* v3 = v2 + stride;
+            for (size_t r = 0; r < stride; ++r) {
+                uint8_t m = min(min(v0[r], v1[r]), min(v2[r], v3[r])) + 1;
+                v0[r] = min(v0[r], m);
+                v1[r] = min(v1[r], m);
+                v2[r] = min(v2[r], m);
+                v3[r] = min(v3[r], m);
+            }
+        }
+    }
+
+    // windows with many unknown positions can only win where everything else is further away
+    if (!deferred.empty()) {
+        for (size_t x = 0; x < size; ++x) {
+            if (dist[x] <= deferredMin) {
+                continue;
+            }
+            for (const auto& window : deferred) {
+                uint64_t diff = x ^ window.kmer;
+                int d = __builtin_popcountll(((diff | (diff >> 1)) & EVEN_BITS) | window.invalid);
+                dist[x] = min<uint8_t>(dist[x], d);
+            }
+        }
+    }
+
+    return dist;
+}
+
+
+vector<uint16_t> distanceLandscape(const vector<PackedSequence>& sequences, int K) {
+    if (sequences.size() * K > UINT16_MAX) {
+        throw invalid_argument("too many sequences for a 16-bit distance landscape");
+    }
+    vector<uint16_t> total(1ULL << (2 * K), 0);
+    for (const auto& seq : sequences) {
+        addToLandscape(total, summarizeSequence(seq, K));
+    }
+    return total;
+}
+
+
+void addToLandscape(vector<uint16_t>& landscape, const KmerSummary& summary) {
+    vector<uint8_t> dist = distanceTransform(summary);
+    for (size_t x = 0; x < landscape.size(); ++x) {
+        landscape[x] += dist[x];
+    }
+}
+
+
+void bestInLandscape(const vector<uint16_t>& landscape, int K, uint64_t& bestKmer, int& bestDistance) {
+    uint16_t best = *min_element(landscape.begin(), landscape.end());
+
+    uint64_t bestKey = UINT64_MAX;
+    for (size_t x = 0; x < landscape.size(); ++x) {
+        if (landscape[x] == best && lexicalKey(x, K) < bestKey) {
+            bestKey = lexicalKey(x, K);
+            bestKmer = x;
+        }
+    }
+    bestDistance = best;
+}
+
+
+void hypercube_search(const vector<PackedSequence>& sequences, uint64_t& bestKmer, int& bestDistance, int K) {
+    STATS_ONLY(SearchStats stats("hypercube", K, 1);)
+    bestInLandscape(distanceLandscape(sequences, K), K, bestKmer, bestDistance);
+    // every k-mer is scored, but no window is compared against a candidate
+    STATS_ONLY(stats.worker(0).nodes[K] = 1ULL << (2 * K);)
+    STATS_ONLY(stats.improvement(0, bestKmer, bestDistance);)
+    STATS_ONLY(stats.finish(bestDistance);)
+}
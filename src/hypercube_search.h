@@ -0,0 +1,33 @@
+#ifndef MEDIAN_STRING_HYPERCUBE_SEARCH_H
+#define MEDIAN_STRING_HYPERCUBE_SEARCH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "packed_sequence.h"
+#include "kmer_summary.h"
+
+
+// largest K the hypercube engine accepts; it holds two 4^K tables
+const int MAX_HYPERCUBE_K = 13;
+
+// distanceToSequence for every k-mer at once, indexed by packed word. the k-mers present in
+// seq are marked 0 and a min-plus sweep along each of the K axes of the Hamming hypercube
+// spreads them out; costs O(4^K * K) no matter how long seq is
+std::vector<uint8_t> distanceTransform(const PackedSequence& seq, int K);
+std::vector<uint8_t> distanceTransform(const KmerSummary& summary);
+
+// distanceTotal for every k-mer, indexed by packed word. sequences.size() * K must fit in 16 bits
+std::vector<uint16_t> distanceLandscape(const std::vector<PackedSequence>& sequences, int K);
+
+// fold one more sequence into a landscape (4^K zeros to start); lets streamed input be
+// scored one record at a time
+void addToLandscape(std::vector<uint16_t>& landscape, const KmerSummary& summary);
+
+// smallest landscape value, ties broken towards the lexicographically smallest k-mer
+void bestInLandscape(const std::vector<uint16_t>& landscape, int K, uint64_t& bestKmer, int& bestDistance);
+
+// median read straight off the landscape. ties go to the lexicographically smallest k-mer
+void hypercube_search(const std::vector<PackedSequence>& sequences, uint64_t& bestKmer, int& bestDistance, int K);
+
+#endif
@@ -0,0 +1,122 @@
+#include "kmer_summary.h"
+
+#include <stdexcept>
+
+#include "fasta_loader.h"
+
+using namespace std;
+
+
+namespace {
+
+KmerSummary emptySummary(int K) {
+    if (K < 1 || K > MAX_SUMMARY_K) {
+        throw invalid_argument("k-mer length out of range for a summary");
+    }
+    KmerSummary summary;
+    summary.K = K;
+    summary.presence.assign(((1ULL << (2 * K)) + 63) / 64, 0);
+    return summary;
+}
+
+// keeps invalidWindows distinct; every window made only of non-ACGT characters, for one,
+// collapses into a single entry
+void addInvalidWindow(KmerSummary& summary, set<pair<uint64_t, uint64_t>>& seen, uint64_t kmer, uint64_t invalid) {
+    if (seen.insert({kmer, invalid}).second) {
+        summary.invalidWindows.push_back({kmer, invalid});
+    }
+}
+
+
+class SummarySink : public FastaSink {
+public:
+    SummarySink(int K, const function<void(KmerSummary&&)>& onRecord) : K(K), onRecord(onRecord), builder(K) {}
+
+    void beginRecord(const string&) override {
+        builder = SummaryBuilder(K);
+    }
+
+    void appendSequence(const char* data, size_t n) override {
+        builder.append(data, n);
+    }
+
+    void endRecord() override {
+        KmerSummary summary = builder.finish();
+        if (summary.length > 0) {
+            onRecord(move(summary));
+        }
+    }
+
+private:
+    int K;
+    const function<void(KmerSummary&&)>& onRecord;
+    SummaryBuilder builder;
+};
+
+}
+
+
+SummaryBuilder::SummaryBuilder(int K) : summary(emptySummary(K)) {}
+
+
+void SummaryBuilder::append(const char* data, size_t n) {
+    int K = summary.K;
+    int top = 2 * (K - 1);
+    for (size_t k = 0; k < n; ++k) {
+        int code = encodeNT(data[k]);
+        // shift the window one position along; the new nucleotide enters at position K-1
+        window >>= 2;
+        invalid >>= 2;
+        if (code < 0) {
+            invalid |= 1ULL << top;
+        } else {
+            window |= static_cast<uint64_t>(code) << top;
+        }
+        summary.length++;
+        if (summary.length >= static_cast<size_t>(K)) {
+            addWindow();
+        }
+    }
+}
+
+
+void SummaryBuilder::addWindow() {
+    if (invalid == 0) {
+        summary.presence[window >> 6] |= 1ULL << (window & 63);
+    } else {
+        addInvalidWindow(summary, invalidSeen, window, invalid);
+    }
+}
+
+
+KmerSummary SummaryBuilder::finish() {
+    KmerSummary done = move(summary);
+    summary = emptySummary(done.K);
+    window = 0;
+    invalid = 0;
+    invalidSeen.clear();
+    return done;
+}
+
+
+KmerSummary summarizeSequence(const PackedSequence& seq, int K) {
+    KmerSummary summary = emptySummary(K);
+    summary.length = seq.length;
+    set<pair<uint64_t, uint64_t>> seen;
+    for (size_t i = 0; i + K <= seq.length; ++i) {
+        uint64_t kmer = packedWindow(seq.bits, i, K);
+        uint64_t invalid = seq.hasInvalid ? packedWindow(seq.invalid, i, K) : 0;
+        if (invalid == 0) {
+            summary.presence[kmer >> 6] |= 1ULL << (kmer & 63);
+        } else {
+            addInvalidWindow(summary, seen, kmer, invalid);
+        }
+    }
+    return summary;
+}
+
+
+void summarizeFasta(const string& path, int K, const function<void(KmerSummary&&)>& onRecord) {
+    SummarySink sink(K, onRecord);
+    streamFasta(path, sink);
+}
@@ -0,0 +1,57 @@
+#ifndef MEDIAN_STRING_KMER_SUMMARY_H
+#define MEDIAN_STRING_KMER_SUMMARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "packed_sequence.h"
+
+
+// largest K a summary can be built for; the presence bitset holds 4^K bits
+const int MAX_SUMMARY_K = 13;
+
+// everything the searches need from one sequence at a fixed K: which k-mers occur in it.
+// its size depends on K, never on the length of the sequence
+struct KmerSummary {
+    int K = 0;
+    size_t length = 0;
+    // bit x is set when k-mer x occurs as a window with only ACGT characters
+    std::vector<uint64_t> presence;
+    // distinct windows touching non-ACGT characters, as (kmer, invalid plane) pairs in the
+    // packed layout. such positions read as A in kmer and are flagged 0b01 in the plane
+    std::vector<std::pair<uint64_t, uint64_t>> invalidWindows;
+
+    bool contains(uint64_t kmer) const { return (presence[kmer >> 6] >> (kmer & 63)) & 1; }
+};
+
+
+// reduces a sequence to its summary in one pass over the characters, holding only the
+// current window
+class SummaryBuilder {
+public:
+    explicit SummaryBuilder(int K);
+
+    void append(const char* data, size_t n);
+    KmerSummary finish();
+
+private:
+    void addWindow();
+
+    KmerSummary summary;
+    uint64_t window = 0;
+    uint64_t invalid = 0;
+    std::set<std::pair<uint64_t, uint64_t>> invalidSeen;
+};
+
+KmerSummary summarizeSequence(const PackedSequence& seq, int K);
+
+// stream a fasta file and hand over each record's summary as soon as the record ends.
+// records without sequence are skipped
+void summarizeFasta(const std::string& path, int K, const std::function<void(KmerSummary&&)>& onRecord);
+
+#endif
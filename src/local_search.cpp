@@ -0,0 +1,95 @@
+#include "local_search.h"
+
+#include <algorithm>
+#include <random>
+
+#include "search_stats.h"
+
+using namespace std;
+
+
+void scoreNeighbours(const WindowIndex& index, uint64_t kmer, vector<int>& neighbours) {
+    int K = index.K;
+    STATS_ONLY(statsAddWindows(index.totalWindows);)
+    neighbours.assign(4 * K, 0);
+    vector<uint8_t> counts;
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        size_t windows = index.windows[s];
+        counts.assign(windows, 0);
+        for (int j = 0; j < K; ++j) {
+            const uint8_t* nt = index.plane(s, j);
+            uint8_t own = (kmer >> (2 * j)) & 3;
+            for (size_t w = 0; w < windows; ++w) {
+                counts[w] += nt[w] != own;
+            }
+        }
+
+        for (int j = 0; j < K; ++j) {
+            const uint8_t* nt = index.plane(s, j);
+            uint8_t own = (kmer >> (2 * j)) & 3;
+            for (uint8_t c = 0; c < 4; ++c) {
+                // a window never has more than K mismatches, as for an empty sequence
+                uint8_t minCount = static_cast<uint8_t>(K);
+                for (size_t w = 0; w < windows; ++w) {
+                    uint8_t count = counts[w] - (nt[w] != own) + (nt[w] != c);
+                    minCount = min(minCount, count);
+                }
+                neighbours[4 * j + c] += minCount;
+            }
+        }
+    }
+}
+
+
+namespace {
+
+// steepest descent from kmer; returns the distance of the local optimum it ends on
+int descend(const WindowIndex& index, uint64_t& kmer, vector<int>& neighbours) {
+    scoreNeighbours(index, kmer, neighbours);
+    int distance = neighbours[kmer & 3];
+    while (true) {
+        int bestMove = -1;
+        int bestDistance = distance;
+        for (int move = 0; move < 4 * index.K; ++move) {
+            if (neighbours[move] < bestDistance) {
+                bestDistance = neighbours[move];
+                bestMove = move;
+            }
+        }
+        if (bestMove < 0) {
+            return distance;
+        }
+        int j = bestMove / 4;
+        kmer = (kmer & ~(3ULL << (2 * j))) | (static_cast<uint64_t>(bestMove % 4) << (2 * j));
+        distance = bestDistance;
+        scoreNeighbours(index, kmer, neighbours);
+    }
+}
+
+}
+
+
+int polishKmer(const WindowIndex& index, uint64_t& kmer, int restarts) {
+    int K = index.K;
+    vector<int> neighbours;
+    int best = descend(index, kmer, neighbours);
+
+    // each restart changes about a third of the positions of the best k-mer, enough to
+    // leave its basin while keeping most of what it got right
+    mt19937 gen(1);
+    int changes = max(2, K / 3);
+    for (int r = 0; r < restarts; ++r) {
+        uint64_t candidate = kmer;
+        for (int i = 0; i < changes; ++i) {
+            int j = gen() % K;
+            uint64_t code = (((candidate >> (2 * j)) & 3) + 1 + gen() % 3) & 3;
+            candidate = (candidate & ~(3ULL << (2 * j))) | (code << (2 * j));
+        }
+        int distance = descend(index, candidate, neighbours);
+        if (distance < best) {
+            best = distance;
+            kmer = candidate;
+        }
+    }
+    return best;
+}
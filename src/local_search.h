@@ -0,0 +1,22 @@
+#ifndef MEDIAN_STRING_LOCAL_SEARCH_H
+#define MEDIAN_STRING_LOCAL_SEARCH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "search.h"
+
+
+// distance of every Hamming-1 neighbour of kmer against index: neighbours[4 * j + c] is kmer
+// with position j set to c, so the entry for its own code there is kmer's distance. a single
+// pass over the windows scores all 3K neighbours: a window's mismatch count against kmer is
+// patched at one position per neighbour instead of being recounted
+void scoreNeighbours(const WindowIndex& index, uint64_t kmer, std::vector<int>& neighbours);
+
+// steepest descent from kmer: move to the closest Hamming-1 neighbour until none is closer.
+// with restarts > 0, the descent is repeated that many times from random perturbations of
+// the best k-mer so far (fixed seed, so runs repeat). kmer ends as the best k-mer found and
+// its distance is returned
+int polishKmer(const WindowIndex& index, uint64_t& kmer, int restarts = 0);
+
+#endif
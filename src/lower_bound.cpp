@@ -0,0 +1,227 @@
+#include "lower_bound.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <sstream>
+#include <stdexcept>
+
+#include "hypercube_search.h"
+
+using namespace std;
+
+
+int TailTableBound::bound(const WindowIndex& index, const PrefixState&, int iter, int prefixDistance, int) const {
+    return prefixDistance + tail[index.K - iter];
+}
+
+
+int LookaheadBound::bound(const WindowIndex& index, const PrefixState& state, int iter, int, int limit) const {
+    int rest = tail[index.K - iter - 1];
+    int totals[4] = {0, 0, 0, 0};
+    // in the order the other scans of this row have learned
+    for (uint32_t s : state.sequenceOrders[iter].order) {
+        ActiveWindows active = activeWindows(index, state, iter, s);
+        const uint8_t* in = active.counts;
+        const uint8_t* nt = index.plane(s, iter);
+        size_t windows = active.size;
+        // best window overall, and best window whose next code is c. windows with another code
+        // are masked to 0xFF instead of branched over, which keeps the loop vectorizable
+        uint8_t all = UINT8_MAX;
+        uint8_t m0 = UINT8_MAX, m1 = UINT8_MAX, m2 = UINT8_MAX, m3 = UINT8_MAX;
+        size_t end = 0;
+        if (active.ids) {
+            for (size_t i = 0; i < windows; ++i) {
+                uint8_t a = in[i];
+                uint8_t n = nt[active.ids[i]];
+                all = min(all, a);
+                m0 = min(m0, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 0))));
+                m1 = min(m1, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 1))));
+                m2 = min(m2, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 2))));
+                m3 = min(m3, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 3))));
+            }
+            end = windows;
+        }
+        while (end < windows) {
+            size_t begin = end;
+            end = min(windows, begin + EXIT_CHECK_WINDOWS);
+            for (size_t w = begin; w < end; ++w) {
+                uint8_t a = in[w];
+                uint8_t n = nt[w];
+                all = min(all, a);
+                m0 = min(m0, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 0))));
+                m1 = min(m1, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 1))));
+                m2 = min(m2, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 2))));
+                m3 = min(m3, static_cast<uint8_t>(a | static_cast<uint8_t>(-(n != 3))));
+            }
+            // every next nucleotide already has a window matching it exactly
+            if ((m0 | m1 | m2 | m3) == 0) {
+                break;
+            }
+        }
+        int mismatch = all + 1;
+        totals[0] += min<int>(m0, mismatch);
+        totals[1] += min<int>(m1, mismatch);
+        totals[2] += min<int>(m2, mismatch);
+        totals[3] += min<int>(m3, mismatch);
+        if (*min_element(totals, totals + 4) + rest >= limit) {
+            break;
+        }
+    }
+    return *min_element(totals, totals + 4) + rest;
+}
+
+
+namespace {
+
+// median of the L-suffix windows by distance transform: exact, O(4^L * L) per sequence
+int transformTail(const WindowIndex& index, int L, uint64_t& median) {
+    int K = index.K;
+    vector<uint32_t> landscape(1ULL << (2 * L), 0);
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        KmerSummary summary;
+        summary.K = L;
+        summary.presence.assign(((1ULL << (2 * L)) + 63) / 64, 0);
+        for (size_t w = 0; w < index.windows[s]; ++w) {
+            uint64_t kmer = 0;
+            uint64_t invalid = 0;
+            for (int j = 0; j < L; ++j) {
+                uint8_t code = index.plane(s, K - L + j)[w];
+                if (code == INVALID_CODE) {
+                    invalid |= 1ULL << (2 * j);
+                } else {
+                    kmer |= static_cast<uint64_t>(code) << (2 * j);
+                }
+            }
+            if (invalid) {
+                summary.invalidWindows.push_back({kmer, invalid});
+            } else {
+                summary.presence[kmer >> 6] |= 1ULL << (kmer & 63);
+            }
+        }
+        sort(summary.invalidWindows.begin(), summary.invalidWindows.end());
+        summary.invalidWindows.erase(unique(summary.invalidWindows.begin(), summary.invalidWindows.end()),
+                                     summary.invalidWindows.end());
+
+        vector<uint8_t> dist = distanceTransform(summary);
+        for (size_t x = 0; x < landscape.size(); ++x) {
+            landscape[x] += dist[x];
+        }
+    }
+    auto best = min_element(landscape.begin(), landscape.end());
+    median = best - landscape.begin();
+    return *best;
+}
+
+// median of the L-suffix windows by branch and bound, pruned by the tails below L. the
+// L-suffix of an L-suffix window is the window's own L'-suffix, so tail[L'] applies as is
+int searchTail(const WindowIndex& index, int L, const vector<int>& tail, uint64_t& median) {
+    WindowIndex suffix = suffixWindowIndex(index, L);
+    prepareTailSolve(suffix);
+
+    // the previous median is the suffix of a good L-mer: try it behind each nucleotide
+    uint64_t shorter = median;
+    int distance = INT_MAX;
+    for (uint64_t code = 0; code < 4; ++code) {
+        uint64_t kmer = (shorter << 2) | code;
+        int d = indexDistance(suffix, kmer);
+        if (d < distance) {
+            distance = d;
+            median = kmer;
+        }
+    }
+
+    vector<unique_ptr<LowerBound>> bounds;
+    bounds.push_back(make_unique<TailTableBound>(vector<int>(tail.begin(), tail.begin() + L + 1)));
+    BoundSet set(move(bounds));
+    branch_and_bound(suffix, median, distance, tail[L - 1], &set);
+    return distance;
+}
+
+}
+
+
+vector<int> suffixTailTable(const WindowIndex& index, int maxExact) {
+    int K = index.K;
+    vector<int> tail(K + 1, 0);
+    // L = K would be the whole problem
+    int exact = min(maxExact, K - 1);
+
+    uint64_t median = 0;
+    for (int L = 1; L <= exact; ++L) {
+        tail[L] = L <= TRANSFORM_TAIL_L ? transformTail(index, L, median) : searchTail(index, L, tail, median);
+    }
+    // a longer suffix contains the shorter one, so its best distance is never lower
+    for (int L = 1; L <= K; ++L) {
+        tail[L] = max(tail[L], tail[L - 1]);
+    }
+    return tail;
+}
+
+
+vector<string> BoundSet::names() const {
+    vector<string> result;
+    for (const auto& b : bounds) {
+        result.push_back(b->name());
+    }
+    return result;
+}
+
+
+int BoundSet::evaluate(const WindowIndex& index, const PrefixState& state, int iter, int prefixDistance,
+                       int limit, [[maybe_unused]] WorkerStats* stats) const {
+    int best = prefixDistance;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        STATS_ONLY(auto start = chrono::steady_clock::now();)
+        best = max(best, bounds[i]->bound(index, state, iter, prefixDistance, limit));
+        STATS_ONLY(
+            if (stats) {
+                stats->boundEvaluations[i]++;
+                stats->boundNanos[i] += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            })
+        if (best >= limit) {
+            STATS_ONLY(if (stats) stats->boundPrunes[i]++;)
+            return best;
+        }
+    }
+    return best;
+}
+
+
+vector<string> parseBoundSpec(const string& spec) {
+    vector<string> names;
+    stringstream parts(spec);
+    string name;
+    while (getline(parts, name, ',')) {
+        if (name != "prefix" && name != "table" && name != "lookahead") {
+            throw invalid_argument("unknown lower bound '" + name + "' (expected prefix, table or lookahead)");
+        }
+        if (find(names.begin(), names.end(), name) == names.end()) {
+            names.push_back(name);
+        }
+    }
+    if (names.empty()) {
+        throw invalid_argument("empty lower bound list");
+    }
+    return names;
+}
+
+
+unique_ptr<BoundSet> makeBoundSet(const string& spec, const WindowIndex& index) {
+    vector<string> names = parseBoundSpec(spec);
+    names.erase(remove(names.begin(), names.end(), "prefix"), names.end());
+    if (names.empty()) {
+        return nullptr;
+    }
+
+    vector<int> tail = suffixTailTable(index, min(index.K - 1, MAX_EXACT_TAIL_L));
+    vector<unique_ptr<LowerBound>> bounds;
+    for (const auto& name : names) {
+        if (name == "table") {
+            bounds.push_back(make_unique<TailTableBound>(tail));
+        } else if (name == "lookahead") {
+            bounds.push_back(make_unique<LookaheadBound>(tail));
+        }
+    }
+    return make_unique<BoundSet>(move(bounds));
+}
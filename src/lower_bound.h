@@ -0,0 +1,97 @@
+#ifndef MEDIAN_STRING_LOWER_BOUND_H
+#define MEDIAN_STRING_LOWER_BOUND_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "search.h"
+#include "search_stats.h"
+
+
+// admissible lower bound on the distance of every k-mer extending a prefix. a bound must
+// never exceed the true distance of any completion, or the search loses the optimum
+class LowerBound {
+public:
+    virtual ~LowerBound() = default;
+
+    virtual const char* name() const = 0;
+
+    // bound for the prefix of length iter held in row iter of state, whose own distance is
+    // prefixDistance. iter < index.K. a bound may stop early once it reaches limit and return
+    // any value >= limit
+    virtual int bound(const WindowIndex& index, const PrefixState& state, int iter, int prefixDistance,
+                      int limit) const = 0;
+};
+
+
+// prefix distance plus tail[K - iter]. a window's distance splits into its prefix part and
+// its suffix part, and the per-sequence minimum of a sum is at least the sum of the minima,
+// so any lower bound on the suffix alone can be added
+class TailTableBound : public LowerBound {
+public:
+    explicit TailTableBound(std::vector<int> tail) : tail(std::move(tail)) {}
+    const char* name() const override { return "table"; }
+    int bound(const WindowIndex& index, const PrefixState& state, int iter, int prefixDistance,
+              int limit) const override;
+
+private:
+    std::vector<int> tail;
+};
+
+// one position further: per sequence, the best window after placing each nucleotide next,
+// summed and minimized over the nucleotide, plus tail[K - iter - 1]. a single pass over the
+// windows instead of the four of expanding the children
+class LookaheadBound : public LowerBound {
+public:
+    explicit LookaheadBound(std::vector<int> tail) : tail(std::move(tail)) {}
+    const char* name() const override { return "lookahead"; }
+    int bound(const WindowIndex& index, const PrefixState& state, int iter, int prefixDistance,
+              int limit) const override;
+
+private:
+    std::vector<int> tail;
+};
+
+
+// tail[L] for L = 0..K: the best distance any L-mer reaches against the last L positions of
+// the K-length windows, i.e. the median of suffixWindowIndex(index, L). solved exactly for
+// every L < K up to maxExact, shortest first: small L with one distance transform per
+// sequence, larger L by branch and bound bounded by the shorter tails, with the previous
+// median extended by one nucleotide as the seed and the previous optimum as the floor.
+// beyond maxExact the last value is carried upward, since the optimum never shrinks with L
+std::vector<int> suffixTailTable(const WindowIndex& index, int maxExact);
+
+// largest L the tail table solves with distance transforms; 4^L entries per sequence
+const int TRANSFORM_TAIL_L = 8;
+
+// largest L makeBoundSet solves exactly. each longer tail is a median problem nearly as hard
+// as the search it bounds, so at large K the longest tails are carried instead
+const int MAX_EXACT_TAIL_L = 10;
+
+
+// the bounds a search consults at each inner node, combined by taking their maximum
+class BoundSet {
+public:
+    explicit BoundSet(std::vector<std::unique_ptr<LowerBound>> bounds) : bounds(std::move(bounds)) {}
+
+    std::vector<std::string> names() const;
+
+    // evaluates the bounds in order and stops at the first that reaches limit. stats, if
+    // given, counts evaluations, time and prunes per bound in the order of names()
+    int evaluate(const WindowIndex& index, const PrefixState& state, int iter, int prefixDistance,
+                 int limit, WorkerStats* stats) const;
+
+private:
+    std::vector<std::unique_ptr<LowerBound>> bounds;
+};
+
+// bound names from a comma separated spec of prefix, table and lookahead. "prefix" is the
+// prefix distance itself, which branch_and_bound always checks before consulting a BoundSet.
+// throws invalid_argument on an unknown name
+std::vector<std::string> parseBoundSpec(const std::string& spec);
+
+// bounds for one search over index. null when the spec adds nothing to the prefix distance
+std::unique_ptr<BoundSet> makeBoundSet(const std::string& spec, const WindowIndex& index);
+
+#endif
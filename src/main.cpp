@@ -1,237 +1,481 @@
 #include <iostream> 
-#include <fstream>
 #include <string>
 #include <vector>
 #include <array>
 #include <algorithm>
 #include <climits>
-#include <cmath>
 #include <stdexcept>
-#include <unordered_map>
-#include <random>
-#include <iterator>
-
-using namespace std;
+#include <cstdint>
+#include <thread>
+#include <fstream>
 
+#include "packed_sequence.h"
+#include "window_kernels.h"
+#include "search.h"
+#include "parallel_search.h"
+#include "exhaustive_search.h"
+#include "hypercube_search.h"
+#include "fasta_loader.h"
+#include "kmer_summary.h"
+#include "median_string.h"
+#include "solver.h"
+#include "batch.h"
+#include "search_stats.h"
+#include "lower_bound.h"
 
-//define alphabet 
-const vector<char> NT = {'A','C','G','T'};
+using namespace std;
 
 
-// calc hamming distance between 2 strings
-int hammingDistance(const string& str1, const string& str2) {
-    if(str1.length() != str2.length()) {
-        throw invalid_argument("strings must be of equal length");
-    }
-    int dist = 0;
-    for (size_t i=0; i < str1.length(); ++i) {
-        if (str1[i] != str2[i]) {
-                dist++;
+// check that file contents are loaded correctly
+void checkSequences(const vector<PackedSequence>& sequences, size_t NT = 10){
+    cout << "Checking first " << NT << " nucleotides of each sequence: " << endl;
+    for (size_t i=0; i < sequences.size(); ++i) {
+        cout << "Sequence " << i + 1 << ": ";
+        size_t shown = min(NT, sequences[i].length);
+        for (size_t j=0; j < shown; ++j) {
+            int code = ntCodeOrInvalid(sequences[i], j);
+            cout << (code < 0 ? 'N' : "ACGT"[code]);
         }
-    }
-     
-    return dist;
-}
-
-
-// helper function for distance calculation
-int distanceToSequence(const string& kmer, const string& seq) {
-    int minDist = numeric_limits<int>::max();
-    for (size_t i=0; i <= seq.length() - kmer.length(); i++) {
-        int dist = hammingDistance(kmer, seq.substr(i, kmer.length()));
-        if (dist < minDist) {
-            minDist = dist;
+        if (sequences[i].length <= NT) {
+            cout << " (full sequence; total length: " << sequences[i].length << ")";
+        } else {
+            cout << " (partial sequence; total length: " << sequences[i].length << ")";
         }
+        cout << endl;    
     }
-  
-    return minDist;
+    cout << endl;
+
 }
 
 
-// calculate distance between 2 strings
-int distanceTotal(const string& kmer, const vector<string>& sequences) {
-    int total = 0;
-    //cout << "calculating total distance for k-mer: " << kmer << endl;
-    for (const auto& seq : sequences) {
-        int dist = distanceToSequence(kmer, seq);
-        total += dist;
-        //cout << "distance for kmer " << kmer << " : " << dist << endl;
+// command line settings
+struct Options {
+    vector<string> inputPaths;
+    SearchSettings search;
+    bool stream = false;
+    string kmerSpec;        // empty: prompt for K
+    bool batch = false;
+    string manifestPath;
+    string statsPath;       // instrumented builds only; "-" for stdout
+};
+
+
+// parse a non-negative integer option value, reporting errors on cerr
+bool parseCount(const string& option, const char* value, int& out) {
+    try {
+        size_t used = 0;
+        out = stoi(value, &used);
+        if (used == string(value).length() && out >= 0) {
+            return true;
+        }
+    } catch (const exception&) {
     }
-    //cout << "total dist: " << total << endl;
-    return total;
+    cerr << "Error: " << option << " expects a non-negative integer." << endl;
+    return false;
 }
 
 
-// find a more suitable starting string at the cost of reproducability 
-// builds the starting k-mer from sampling of input sequences, calculating the most frequent nucleotide at each position
-// risk of introducing bias 
-string HeuristicKmer(const vector<string>& sequences, int K) {
-    array<int, 4> countNT = {0,0,0,0};
-    int counter = 0;
-
-    // seeding random generator
-    random_device rd;
-    mt19937 gen(rd());
-    int sampleSize = min(10000, static_cast<int>(sequences.size() * K));
-
-    // sampling loop. select random sequence, seqIter, and random start position, posIter, for NT counting
-    for (int i = 0; i < sampleSize; ++i) {
-        int seqIter = gen() % sequences.size();
-        int posIter = gen() % (sequences[seqIter].length() - K + 1);
-
-        char c = sequences[seqIter][posIter];
-        // if A,C,G,T found in sequence, increment counter for that NT. 
-        auto j = find(NT.begin(), NT.end(), c);
-        if (j != NT.end()) {
-            countNT[distance(NT.begin(), j)]++;
-            counter++;
-        }
-    }
-
-    // build starting kmer
-    string startKmer(K, 'A');
-    for (int i=0; i < K; i++){
-        int maxCount = 0;
-        int maxIndex = 0;
-        for (int j=0; j < NT.size(); j++){
-            if (countNT[j] > maxCount) {
-                maxCount = countNT[j];
-                maxIndex = j;    
+bool parseOptions(int argc, char* argv[], Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads" || arg == "--split-depth" || arg == "--queue-mb" || arg == "--restarts") {
+            if (i + 1 >= argc) {
+                cerr << "Error: " << arg << " expects a value." << endl;
+                return false;
+            }
+            int& target = arg == "--threads" ? opts.search.threads
+                        : arg == "--split-depth" ? opts.search.splitDepth
+                        : arg == "--queue-mb" ? opts.search.queueMegabytes : opts.search.restarts;
+            if (!parseCount(arg, argv[++i], target)) {
+                return false;
+            }
+        } else if (arg == "--engine" || arg == "-k" || arg == "--kmer" || arg == "--manifest" || arg == "--stats"
+                   || arg == "--bound" || arg == "--tail-solve" || arg == "--order") {
+            if (i + 1 >= argc) {
+                cerr << "Error: " << arg << " expects a value." << endl;
+                return false;
             }
+            string value = argv[++i];
+            if (arg == "--manifest") {
+                opts.manifestPath = value;
+                opts.batch = true;
+            } else if (arg == "--tail-solve") {
+                if (!parseCount(arg, value.c_str(), opts.search.tailLength)) {
+                    return false;
+                }
+            } else if (arg == "--order") {
+                if (!isChildOrder(value)) {
+                    cerr << "Error: unknown child order " << value << " (expected fixed, frequency or best)." << endl;
+                    return false;
+                }
+                opts.search.order = value;
+            } else if (arg == "--bound") {
+                try {
+                    parseBoundSpec(value);
+                } catch (const invalid_argument& e) {
+                    cerr << "Error: " << e.what() << "." << endl;
+                    return false;
+                }
+                opts.search.bounds = value;
+            } else if (arg == "--stats") {
+#ifndef MEDIAN_STATS
+                cerr << "Error: --stats needs a build configured with -DMEDIAN_STATS=ON." << endl;
+                return false;
+#endif
+                opts.statsPath = value;
+            } else if (arg != "--engine") {
+                opts.kmerSpec = value;
+            } else if (value == "bnb" || value == "bestfirst" || value == "portfolio" || value == "bitslice" || value == "gray"
+                       || value == "hypercube" || value == "auto") {
+                opts.search.engine = value;
+            } else {
+                cerr << "Error: unknown engine " << value << " (expected bnb, bestfirst, portfolio, bitslice, gray, hypercube or auto)." << endl;
+                return false;
+            }
+        } else if (arg == "--stream") {
+            opts.stream = true;
+        } else if (arg == "--no-polish") {
+            opts.search.polish = false;
+        } else if (arg == "--no-adaptive-order") {
+            opts.search.adaptiveOrder = false;
+        } else if (arg == "--batch") {
+            opts.batch = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            cerr << "Error: unknown option " << arg << endl;
+            return false;
+        } else {
+            opts.inputPaths.push_back(arg);
         }
-        startKmer[i] = NT[maxIndex];
-        // zero NT counts after selection of each position
-        countNT[maxIndex] = 0;
     }
-
-    return startKmer;
-            
+    if (opts.batch) {
+        if (opts.stream) {
+            cerr << "Error: --stream cannot be combined with batch mode." << endl;
+            return false;
+        }
+        if (opts.inputPaths.empty() && opts.manifestPath.empty()) {
+            cerr << "Please provide multi-fasta input files or a manifest." << endl;
+            return false;
+        }
+    } else if (opts.inputPaths.size() != 1) {
+        cerr << "Please provide one multi-fasta input file (or use --batch)." << endl;
+        return false;
+    }
+    // --threads 0 uses every hardware thread
+    if (opts.search.threads == 0) {
+        opts.search.threads = max(1u, thread::hardware_concurrency());
+    }
+    return true;
 }
 
 
-// check that file contents are loaded correctly
-void checkSequences(const vector<string>& sequences, int NT = 10){
-    cout << "Checking first " << NT << " nucleotides of each sequence: " << endl;
-    for (size_t i=0; i < sequences.size(); ++i) {
-        cout << "Sequence " << i + 1 << ": ";
-        if (sequences[i].length() < NT) {
-            cout << sequences[i] << " (full sequence; total length: " << sequences[i].length() << ")";
-        } else {
-            cout << sequences[i].substr(0, NT) << " (partial sequence; total length: " << sequences[i].length() << ")";
-        }
-        cout << endl;    
+// check the requested k-mer length; engines that cannot hold it are swapped in settingsForK
+bool checkKmerLength(int K, const Options& opts) {
+    if (K < 1 || K > MAX_KMER_LENGTH) {
+        cerr << "Error: please provide k-mer length between 1 and " << MAX_KMER_LENGTH << "." << endl;
+        return false;
     }
-    cout << endl;
-
+    if (opts.stream && K > MAX_SUMMARY_K) {
+        cerr << "Error: streaming supports k-mer lengths up to " << MAX_SUMMARY_K << "." << endl;
+        return false;
+    }
+    return true;
 }
 
 
-void branch_and_bound(const vector<string>& sequences, string& currentStr, string& bestStr, int& bestDistance, int iter, int K) {
+// search settings for one run at K over sequences sequences (0 if not known yet), with the
+// engine resolved. an explicit choice that cannot run there is replaced, with a note
+SearchSettings settingsForK(const Options& opts, int K, size_t sequences) {
+    SearchSettings search = opts.search;
+    search.engine = resolveEngine(opts.search.engine, K, sequences);
+    if (search.engine != opts.search.engine && opts.search.engine != "auto") {
+        cerr << "Note: the " << opts.search.engine << " engine cannot run K = " << K << " on this input; using "
+             << search.engine << " instead." << endl;
+    }
+    return search;
+}
 
-    int currentDistance = distanceTotal(currentStr.substr(0, iter), sequences);
 
-    if (currentDistance >= bestDistance) {
-        return;
+// streaming mode: every record is reduced to the set of k-mers it contains while it is read
+// and its sequence is never stored. the hypercube engine folds each summary into the
+// landscape straight away; the other engines index the distinct k-mers and search those
+int runStreamed(const Options& opts, int K) {
+    // the record count is not known up front; the hypercube engine checks it as they come
+    SearchSettings search = settingsForK(opts, K, 0);
+    size_t count = 0;
+    WindowIndex index;
+    vector<uint16_t> landscape;
+    if (search.engine == "hypercube") {
+        landscape.assign(1ULL << (2 * K), 0);
     }
 
-    // reached leaf node
-    if (iter == K) {
-        if (currentDistance < bestDistance) {
-            bestDistance = currentDistance;
-            bestStr = currentStr;
-        }
-        return;
+    STATS_ONLY(statsStartPhase("stream");)
+    try {
+        summarizeFasta(opts.inputPaths.front(), K, [&](KmerSummary&& summary) {
+            count++;
+            cout << "Sequence: " << count << " length: " << summary.length << endl;
+            if (summary.length < static_cast<size_t>(K)) {
+                throw runtime_error("sequence " + to_string(count) + " is shorter than the k-mer length");
+            }
+            if (search.engine == "hypercube") {
+                if (count * K > UINT16_MAX) {
+                    throw runtime_error("too many sequences for the hypercube engine at this k-mer length");
+                }
+                addToLandscape(landscape, summary);
+            } else {
+                appendToWindowIndex(index, summary);
+            }
+        });
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << "." << endl;
+        return 1;
     }
-
-    for (char nucleotide : NT) {
-        currentStr[iter] = nucleotide;
-        //cout << "Exploring current nucleotide " << nucleotide << " at position " << iter << endl;
-        branch_and_bound(sequences, currentStr, bestStr, bestDistance, iter + 1, K);    
+    if (count == 0) {
+        cerr << "Error: no sequences found in input file." << endl;
+        return 1;
     }
 
-}
-
-
-int main(int argc, char* argv[]) {
+    cout << "Search threads: " << search.threads << endl;
+    cout << endl;
 
-    if (argc !=2) {
-        cerr << "Please provide one multi-fasta input file." << endl;
-        return 1;
+    uint64_t bestKmer = 0;
+    int bestDistance = INT_MAX;
+    cout << "Starting streamed " << search.engine << " search with K = " << K << endl;
+    STATS_ONLY(statsStartPhase("streamed search");)
+    if (search.engine == "hypercube") {
+        bestInLandscape(landscape, K, bestKmer, bestDistance);
+    } else if (search.engine == "gray") {
+        gray_code_search(index, bestKmer, bestDistance);
+    } else {
+        prepareSearchIndex(index, search);
+        unique_ptr<BoundSet> bounds = makeBoundSet(search.bounds, index);
+        runSearch(index, bestKmer, bestDistance, search, bounds.get());
     }
+    cout << endl;
+    cout << "streamed final best string: " << decodeKmer(bestKmer, K) << " with final distance: " << bestDistance << endl;
+    cout << endl;
+    return 0;
+}
 
-    ifstream inputFile(argv[1]);
 
-    if (!inputFile) {
-        cerr << "Error: unable to open input file." << endl;
+// batch mode: every file is parsed once and solved for each of its k-mer lengths, with one
+// result row per (file, K) on stdout and nothing read from cin
+int runBatchMode(const Options& opts) {
+    vector<BatchJob> jobs;
+    try {
+        vector<int> lengths;
+        if (!opts.kmerSpec.empty()) {
+            lengths = parseKmerSpec(opts.kmerSpec);
+        }
+        if (!opts.manifestPath.empty()) {
+            jobs = readManifest(opts.manifestPath, lengths);
+        }
+        if (!opts.inputPaths.empty() && lengths.empty()) {
+            throw invalid_argument("batch mode needs k-mer lengths (-k)");
+        }
+        for (const auto& path : opts.inputPaths) {
+            jobs.push_back({path, lengths});
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << "." << endl;
         return 1;
     }
 
-    string line, sequence;
-    vector<string> sequences;
-
-    while (getline(inputFile, line)) {
-        // check for beginning of fasta sequence
-        if (line[0] == '>') {
-            // if sequence exists, add to sequences vector. Then clear sequence string to parse next seq string.
-            if (!sequence.empty()) {
-                sequences.push_back(sequence);
-                sequence.clear();
+    // reject the whole batch up front rather than fail halfway through it
+    for (const auto& job : jobs) {
+        for (int K : job.kmerLengths) {
+            if (!checkKmerLength(K, opts)) {
+                return 1;
             }
-        } else {
-            sequence += line;
         }
     }
-    if (!sequence.empty()) {
-        sequences.push_back(sequence);
+    return runBatch(jobs, opts.search, cout) == 0 ? 0 : 1;
+}
+
+
+#ifdef MEDIAN_STATS
+// write the instrumentation report as JSON, to stdout for "-"
+bool writeStats(const string& path) {
+    if (path == "-") {
+        writeStatsJson(cout);
+        return true;
+    }
+    ofstream out(path);
+    if (out) {
+        writeStatsJson(out);
+    }
+    if (!out) {
+        cerr << "Error: could not write statistics to " << path << "." << endl;
+        return false;
+    }
+    return true;
+}
+#endif
+
+
+// one file, one K: the interactive run
+int runSingle(const Options& opts) {
+
+    // records are encoded straight from the mapped file; nothing is copied into strings.
+    // streaming reads the file only once K is known
+    vector<PackedSequence> packed;
+    if (!opts.stream) {
+        STATS_ONLY(statsStartPhase("parse");)
+        try {
+            packed = loadFasta(opts.inputPaths.front()).sequences;
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << "." << endl;
+            return 1;
+        }
+        STATS_ONLY(statsStopPhase();)
+        if (packed.empty()) {
+            cerr << "Error: no sequences found in input file." << endl;
+            return 1;
+        }
     }
-    
-    inputFile.close();
     
     // grab user input; determine length of desired k-mer
-    // when K <= 4, premature pruning occurs. given small search space, brute force may be used.
-    // when K > 10, performance decreases. Implement optimization techniques like multithreading, bit representation...
     int K;
-    cout << "Provide desired length of k-mer: ";
-    cin >> K;
+    if (!opts.kmerSpec.empty()) {
+        vector<int> lengths;
+        try {
+            lengths = parseKmerSpec(opts.kmerSpec);
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << "." << endl;
+            return 1;
+        }
+        if (lengths.size() != 1) {
+            cerr << "Error: several k-mer lengths need --batch." << endl;
+            return 1;
+        }
+        K = lengths.front();
+    } else {
+        cout << "Provide desired length of k-mer: ";
+        cin >> K;
+    }
 
-    if (K <= 4 || K > 10) {
-        cerr << "Error: please provide k-mer length between 4 and 9." << endl;
+    if (!checkKmerLength(K, opts)) {
         return 1;
     }
-
-    //checkSequences(sequences);
-    for (size_t i=0; i< sequences.size(); ++i) {
-        cout << "Sequence: " << i+1 << " length: " << sequences[i].length() << endl; 
+    if (opts.stream) {
+        return runStreamed(opts, K);
+    }
+    SearchSettings search = settingsForK(opts, K, packed.size());
+
+    //checkSequences(packed);
+    for (size_t i=0; i< packed.size(); ++i) {
+        cout << "Sequence: " << i+1 << " length: " << packed[i].length << endl; 
+        if (packed[i].length < static_cast<size_t>(K)) {
+            cerr << "Error: sequence " << i+1 << " is shorter than the k-mer length." << endl;
+            return 1;
+        }
     }
     
+    cout << "Engine: " << search.engine << endl;
+    cout << "Distance kernel: " << activeWindowKernel().name << endl;
+    cout << "Lower bounds: " << search.bounds << endl;
+    cout << "Child order: " << search.order << endl;
+    cout << "Sequence order: " << (search.adaptiveOrder ? "adaptive" : "input") << endl;
+    cout << "Search threads: " << search.threads << endl;
     cout << endl;
 
+    // distance transform engine: scores every k-mer without scanning a window per candidate
+    if (search.engine == "hypercube") {
+        uint64_t cubeBestKmer = 0;
+        int cubeBestDistance = INT_MAX;
+        cout << "Starting hypercube distance transform with K = " << K << endl;
+        STATS_ONLY(statsStartPhase("hypercube search");)
+        hypercube_search(packed, cubeBestKmer, cubeBestDistance, K);
+        cout << endl;
+        cout << "hypercube final best string: " << decodeKmer(cubeBestKmer, K) << " with final distance: " << cubeBestDistance << endl;
+        cout << endl;
+        return 0;
+    }
+
+    STATS_ONLY(statsStartPhase("index");)
+    WindowIndex index = buildWindowIndex(packed, K);
+    STATS_ONLY(statsStopPhase();)
+
+    // exhaustive engine: one pass over every k-mer, seeding cannot change the result
+    if (search.engine == "gray") {
+        uint64_t grayBestKmer = 0;
+        int grayBestDistance = INT_MAX;
+        cout << "Starting Gray-code exhaustive search with K = " << K << endl;
+        STATS_ONLY(statsStartPhase("gray search");)
+        gray_code_search(index, grayBestKmer, grayBestDistance);
+        cout << endl;
+        cout << "exhaustive final best string: " << decodeKmer(grayBestKmer, K) << " with final distance: " << grayBestDistance << endl;
+        cout << endl;
+        return 0;
+    }
+
+    prepareSearchIndex(index, search);
+    // built once, the heuristic and the naive search share them
+    STATS_ONLY(statsStartPhase("bounds");)
+    unique_ptr<BoundSet> bounds = makeBoundSet(search.bounds, index);
+
     // for naive branch and bound 
-    string bestStr(K,'A');
-    string currentStr = bestStr;
+    uint64_t bestKmer = 0;
     int bestDistance = INT_MAX;
 
     // for heuristic b&b
-    string heurBestStr = HeuristicKmer(sequences, K);
-    string heurCurrentStr = heurBestStr;
-    int heurBestDistance = distanceTotal(heurCurrentStr, sequences);
+    STATS_ONLY(statsStartPhase("heuristic");)
+    uint64_t heurBestKmer = encodeKmer(HeuristicKmer(packed, K, search.threads), K);
+    int heurBestDistance = distanceTotal(heurBestKmer, K, packed);
+    cout << "Heuristic initial string: " << decodeKmer(heurBestKmer, K) << " with start distance: " << heurBestDistance << endl;
+    if (search.polish) {
+        STATS_ONLY(statsStartPhase("polish");)
+        heurBestDistance = polishSeed(index, heurBestKmer, heurBestDistance, search);
+        cout << "Polished initial string: " << decodeKmer(heurBestKmer, K) << " with start distance: " << heurBestDistance << endl;
+    }
+
+    // one run: the portfolio members already cover what the naive search would
+    if (search.engine == "portfolio") {
+        cout << "Starting portfolio search with K = " << K << endl;
+        STATS_ONLY(statsStartPhase("portfolio search");)
+        runSearch(index, heurBestKmer, heurBestDistance, search, bounds.get());
+        cout << endl;
+        cout << "portfolio final best string: " << decodeKmer(heurBestKmer, K) << " with final distance: " << heurBestDistance << endl;
+        cout << endl;
+        return 0;
+    }
 
-    cout << "Heuristic initial string: " << heurBestStr << " with start distance: " << heurBestDistance << endl;
     cout << "Starting heuristic branch and bound with K = " << K << endl;
-    branch_and_bound(sequences, heurCurrentStr, heurBestStr, heurBestDistance, 0, K);
+    STATS_ONLY(statsStartPhase("heuristic search");)
+    runSearch(index, heurBestKmer, heurBestDistance, search, bounds.get());
 
     cout << endl; 
-    cout << "heuristic final best string: " << heurBestStr << " with final distance: " << heurBestDistance << endl;
+    cout << "heuristic final best string: " << decodeKmer(heurBestKmer, K) << " with final distance: " << heurBestDistance << endl;
     cout << endl;
     cout << endl;
 
-    cout << "Naive initial string: " << bestStr << " with start distance: " << bestDistance << endl;
+    cout << "Naive initial string: " << decodeKmer(bestKmer, K) << " with start distance: " << bestDistance << endl;
     cout << "Starting naive branch and bound algo with K = " << K << endl;
-    branch_and_bound(sequences, currentStr, bestStr, bestDistance, 0, K);
+    STATS_ONLY(statsStartPhase("naive search");)
+    runSearch(index, bestKmer, bestDistance, search, bounds.get());
     
     cout << endl;
-    cout << "naive final best string: " << bestStr << " with final distance: " << bestDistance << endl;
+    cout << "naive final best string: " << decodeKmer(bestKmer, K) << " with final distance: " << bestDistance << endl;
     cout << endl;
     return 0;
  }
 
+
+int main(int argc, char* argv[]) {
+
+    Options opts;
+    if (!parseOptions(argc, argv, opts)) {
+        cerr << "Usage: " << argv[0] << " [--engine bnb|bestfirst|portfolio|bitslice|gray|hypercube|auto] [--stream] [--threads N] [--split-depth D] [--queue-mb M] [--bound prefix,table,lookahead] [--tail-solve L] [--order fixed|frequency|best] [--restarts N] [--no-polish] [--no-adaptive-order] [-k K] <input.fasta>" << endl;
+        cerr << "       " << argv[0] << " --batch -k SPEC [--engine E] [--threads N] <input.fasta>..." << endl;
+        cerr << "       " << argv[0] << " --manifest FILE [-k SPEC] [--engine E] [--threads N]" << endl;
+        STATS_ONLY(cerr << "       --stats FILE|- writes search statistics as JSON" << endl;)
+        return 1;
+    }
+    int status = opts.batch ? runBatchMode(opts) : runSingle(opts);
+#ifdef MEDIAN_STATS
+    statsStopPhase();
+    if (!opts.statsPath.empty() && !writeStats(opts.statsPath)) {
+        status = 1;
+    }
+#endif
+    return status;
+}
@@ -0,0 +1,296 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <climits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "packed_sequence.h"
+#include "window_kernels.h"
+#include "search.h"
+#include "median_string.h"
+#include "fasta_loader.h"
+
+using namespace std;
+
+
+// microbenchmarks for the hot paths of the median search. every input is either generated
+// from a fixed seed or read from a fasta file, so runs are comparable across changes.
+// output is one tab separated row per measurement; "-" marks a metric that does not apply.
+// branch_and_bound counts its nodes and windows only in a MEDIAN_STATS build, so its
+// nodes/s and ns/window need one (and include the counters' own cost)
+
+
+struct BenchOptions {
+    string fastaPath = "data/sequences.fasta";
+    int minK = 5;
+    int maxK = 10;
+    double minSeconds = 0.2;   // each measurement repeats until it has run this long
+};
+
+
+struct Dataset {
+    string name;
+    vector<PackedSequence> sequences;
+};
+
+
+// keeps results alive so the optimizer cannot drop the measured call
+volatile uint64_t sink;
+
+
+// seconds per call of fn, repeating it until minSeconds have passed
+template <typename Fn>
+double timePerCall(Fn fn, double minSeconds) {
+    using clock = chrono::steady_clock;
+    size_t reps = 1;
+    while (true) {
+        auto start = clock::now();
+        for (size_t r = 0; r < reps; ++r) {
+            fn();
+        }
+        double elapsed = chrono::duration<double>(clock::now() - start).count();
+        if (elapsed >= minSeconds) {
+            return elapsed / reps;
+        }
+        // aim a little past minSeconds on the next round
+        reps = elapsed > 0 ? max(reps + 1, static_cast<size_t>(reps * 1.2 * minSeconds / elapsed)) : reps * 10;
+    }
+}
+
+
+Dataset syntheticDataset(size_t count, size_t length, uint32_t seed) {
+    mt19937 gen(seed);
+    Dataset data;
+    data.name = "random_" + to_string(count) + "x" + to_string(length);
+    string seq(length, 'A');
+    for (size_t s = 0; s < count; ++s) {
+        for (auto& c : seq) {
+            c = "ACGT"[gen() & 3];
+        }
+        data.sequences.push_back(encodeSequence(seq));
+    }
+    return data;
+}
+
+
+size_t windowCount(const vector<PackedSequence>& sequences, int K) {
+    size_t windows = 0;
+    for (const auto& seq : sequences) {
+        windows += seq.length >= static_cast<size_t>(K) ? seq.length - K + 1 : 0;
+    }
+    return windows;
+}
+
+
+void printRow(const string& bench, const string& input, int K, double nsPerWindow, double nodesPerSecond, double latency) {
+    auto field = [](double value, int precision) {
+        if (value < 0) {
+            return string("-");
+        }
+        ostringstream out;
+        out << fixed << setprecision(precision) << value;
+        return out.str();
+    };
+    cout << bench << '\t' << input << '\t' << (K > 0 ? to_string(K) : "-") << '\t' << field(nsPerWindow, 3)
+         << '\t' << field(nodesPerSecond, 0) << '\t' << field(latency * 1e3, 3) << endl;
+}
+
+
+void benchHamming(const BenchOptions& opts) {
+    mt19937_64 gen(1);
+    vector<uint64_t> words(4096);
+    for (auto& w : words) {
+        w = gen();
+    }
+    double seconds = timePerCall([&] {
+        uint64_t total = 0;
+        for (size_t i = 0; i + 1 < words.size(); ++i) {
+            total += hammingDistance(words[i], words[i + 1]);
+        }
+        sink = total;
+    }, opts.minSeconds);
+    // one "window" per k-mer pair compared
+    printRow("hammingDistance", "random_words", 32, seconds * 1e9 / (words.size() - 1), -1, seconds);
+}
+
+
+// every available kernel on the longest sequence of the dataset, unless even that one has no
+// K-length window
+void benchDistanceToSequence(const BenchOptions& opts, const Dataset& data, int K) {
+    const PackedSequence* longest = &data.sequences.front();
+    for (const auto& seq : data.sequences) {
+        if (seq.length > longest->length) {
+            longest = &seq;
+        }
+    }
+    if (longest->length < static_cast<size_t>(K)) {
+        return;
+    }
+    size_t windows = longest->length - K + 1;
+    uint64_t kmer = encodeKmer(string("ACGTTGCAACGTTGCAACGTTGCAACGTTGCA"), K);
+    string original = activeWindowKernel().name;
+    for (const auto& kernel : availableWindowKernels()) {
+        selectWindowKernel(kernel.name);
+        double seconds = timePerCall([&] { sink = distanceToSequence(kmer, K, *longest); }, opts.minSeconds);
+        printRow(string("distanceToSequence/") + kernel.name, data.name, K, seconds * 1e9 / windows, -1, seconds);
+    }
+    selectWindowKernel(original);
+}
+
+
+void benchDistanceTotal(const BenchOptions& opts, const Dataset& data, int K) {
+    uint64_t kmer = encodeKmer(string("GAGGCTGAGGCTGAGGCTGAGGCTGAGGCTGA"), K);
+    double seconds = timePerCall([&] { sink = distanceTotal(kmer, K, data.sequences); }, opts.minSeconds);
+    size_t windows = windowCount(data.sequences, K);
+    printRow("distanceTotal", data.name, K, windows ? seconds * 1e9 / windows : -1, -1, seconds);
+}
+
+
+void benchHeuristic(const BenchOptions& opts, const Dataset& data, int K) {
+    double seconds = timePerCall([&] { sink = HeuristicKmer(data.sequences, K).size(); }, opts.minSeconds);
+    printRow("HeuristicKmer", data.name, K, -1, -1, seconds);
+}
+
+
+// one node is one child prefix scored by extendPrefix. rows that drop their inactive windows
+// scan fewer than all of them, so the windows per path are counted on a first untimed run;
+// every run after it extends the same path and scans as many
+void benchExtendPrefix(const BenchOptions& opts, const Dataset& data, int K) {
+    WindowIndex index = buildWindowIndex(data.sequences, K);
+    PrefixState state = makePrefixState(index);
+    WorkerStats scanned;
+    for (int iter = 0; iter < K; ++iter) {
+        extendPrefix(index, state, iter, iter & 3, INT_MAX, &scanned);
+    }
+    double seconds = timePerCall([&] {
+        int total = 0;
+        for (int iter = 0; iter < K; ++iter) {
+            total += extendPrefix(index, state, iter, iter & 3);
+        }
+        sink = total;
+    }, opts.minSeconds);
+    double perNode = seconds / K;
+    printRow("extendPrefix", data.name, K, scanned.windows ? seconds * 1e9 / scanned.windows : -1, 1 / perNode, perNode);
+}
+
+
+// one tail solve of the longest tail K allows, below the all-A prefix. one node is the
+// whole subtree the solve replaces
+void benchSolveTail(const BenchOptions& opts, const Dataset& data, int K) {
+    WindowIndex index = buildWindowIndex(data.sequences, K);
+    prepareTailSolve(index, K - 1);
+    if (index.tailLength == 0) {
+        return;
+    }
+    PrefixState state = makePrefixState(index);
+    int iter = K - index.tailLength;
+    for (int j = 0; j < iter; ++j) {
+        extendPrefix(index, state, j, 0);
+    }
+    uint64_t tail = 0;
+    double seconds = timePerCall([&] { sink = solveTail(index, state, iter, INT_MAX, tail); }, opts.minSeconds);
+    printRow("solveTail/L=" + to_string(index.tailLength), data.name, K, seconds * 1e9 / index.totalWindows, 1 / seconds, seconds);
+}
+
+
+// end to end search from the naive start, index build included. a single run, since the
+// larger K can take seconds. nodes/s and ns/window are over the search alone
+void benchBranchAndBound(const Dataset& data, int K) {
+    using clock = chrono::steady_clock;
+    auto start = clock::now();
+    WindowIndex index = buildWindowIndex(data.sequences, K);
+    prepareTailSolve(index);
+    uint64_t bestKmer = 0;
+    int bestDistance = INT_MAX;
+    [[maybe_unused]] auto searchStart = clock::now();
+    branch_and_bound(index, bestKmer, bestDistance);
+    auto end = clock::now();
+    double seconds = chrono::duration<double>(end - start).count();
+    sink = bestKmer;
+    double nsPerWindow = -1;
+    double nodesPerSecond = -1;
+#ifdef MEDIAN_STATS
+    double searchSeconds = chrono::duration<double>(end - searchStart).count();
+    uint64_t nodes = 0;
+    uint64_t windows = 0;
+    statsLastSearch(nodes, windows);
+    nsPerWindow = windows ? searchSeconds * 1e9 / windows : -1;
+    nodesPerSecond = nodes / searchSeconds;
+#endif
+    printRow("branch_and_bound", data.name, K, nsPerWindow, nodesPerSecond, seconds);
+}
+
+
+bool parseBenchOptions(int argc, char* argv[], BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        string value = argv[++i];
+        try {
+            if (arg == "--fasta") {
+                opts.fastaPath = value;
+            } else if (arg == "--min-k") {
+                opts.minK = stoi(value);
+            } else if (arg == "--max-k") {
+                opts.maxK = stoi(value);
+            } else if (arg == "--min-time") {
+                opts.minSeconds = stod(value);
+            } else {
+                return false;
+            }
+        } catch (const exception&) {
+            return false;
+        }
+    }
+    return opts.minK >= 1 && opts.minK <= opts.maxK && opts.maxK <= 32 && opts.minSeconds > 0;
+}
+
+
+int main(int argc, char* argv[]) {
+    BenchOptions opts;
+    if (!parseBenchOptions(argc, argv, opts)) {
+        cerr << "Usage: " << argv[0] << " [--fasta PATH] [--min-k K] [--max-k K] [--min-time SECONDS]" << endl;
+        return 1;
+    }
+
+    // fixed synthetic inputs spanning sequence count and length, plus the real data if present.
+    // --fasta "" skips the file
+    vector<Dataset> datasets;
+    datasets.push_back(syntheticDataset(8, 1000, 11));
+    datasets.push_back(syntheticDataset(8, 10000, 12));
+    datasets.push_back(syntheticDataset(64, 1000, 13));
+    if (!opts.fastaPath.empty()) {
+        try {
+            Dataset file{opts.fastaPath, loadFasta(opts.fastaPath).sequences};
+            if (file.sequences.empty()) {
+                cerr << "Skipping " << opts.fastaPath << ": no sequences found in input file" << endl;
+            } else {
+                datasets.push_back(move(file));
+            }
+        } catch (const exception& e) {
+            cerr << "Skipping " << opts.fastaPath << ": " << e.what() << endl;
+        }
+    }
+
+    cout << "# distance kernel: " << activeWindowKernel().name << endl;
+    cout << "bench\tinput\tK\tns_per_window\tnodes_per_s\tlatency_ms" << endl;
+
+    benchHamming(opts);
+    for (const auto& data : datasets) {
+        for (int K = opts.minK; K <= opts.maxK; ++K) {
+            benchDistanceToSequence(opts, data, K);
+            benchDistanceTotal(opts, data, K);
+            benchHeuristic(opts, data, K);
+            benchExtendPrefix(opts, data, K);
+            benchSolveTail(opts, data, K);
+            benchBranchAndBound(data, K);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "median_string.h"
+
+#include <algorithm>
+#include <climits>
+#include <thread>
+
+#include "window_kernels.h"
+#include "search_stats.h"
+
+using namespace std;
+
+
+
+// helper function for distance calculation
+// the window scan itself is picked at startup for the host CPU, see window_kernels.cpp
+int distanceToSequence(uint64_t kmer, int L, const PackedSequence& seq) {
+    STATS_ONLY(statsAddWindows(seq.length >= static_cast<size_t>(L) ? seq.length - L + 1 : 0);)
+    return scanWindows(kmer, L, seq);
+}
+
+
+// calculate distance between 2 strings
+int distanceTotal(uint64_t kmer, int L, const vector<PackedSequence>& sequences, int cutoff) {
+    int total = 0;
+    for (const auto& seq : sequences) {
+        total += distanceToSequence(kmer, L, seq);
+        if (total >= cutoff) {
+            break;
+        }
+    }
+    return total;
+}
+
+
+namespace {
+
+// add every ACGT-only window of length L of seq to counts, indexed by its packed code
+void countWindows(const PackedSequence& seq, int L, vector<uint32_t>& counts) {
+    uint64_t kmer = 0;
+    int run = 0;   // ACGT positions in a row up to i
+    for (size_t i = 0; i < seq.length; ++i) {
+        int code = ntCodeOrInvalid(seq, i);
+        if (code < 0) {
+            run = 0;
+            continue;
+        }
+        // the first position sits in the low bits, so the oldest code shifts out at the bottom
+        kmer = (kmer >> 2) | (static_cast<uint64_t>(code) << (2 * (L - 1)));
+        if (++run >= L) {
+            counts[kmer]++;
+        }
+    }
+}
+
+}
+
+
+// builds the starting k-mer from exact window counts: every k-mer is counted in one pass
+// over the input, the most frequent ones are scored and the closest is kept
+string HeuristicKmer(const vector<PackedSequence>& sequences, int K, int threads) {
+    int L = min(K, MAX_SEED_COUNT_K);
+    size_t cells = 1ULL << (2 * L);
+
+    // each thread counts a share of the sequences into its own table; they are summed after
+    threads = max(1, min<int>(threads, sequences.size()));
+    vector<vector<uint32_t>> tables(threads, vector<uint32_t>(cells, 0));
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (size_t s = t; s < sequences.size(); s += threads) {
+                countWindows(sequences[s], L, tables[t]);
+            }
+        });
+    }
+    for (size_t s = 0; s < sequences.size(); s += threads) {
+        countWindows(sequences[s], L, tables[0]);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    vector<uint32_t>& counts = tables[0];
+    for (int t = 1; t < threads; ++t) {
+        for (size_t x = 0; x < cells; ++x) {
+            counts[x] += tables[t][x];
+        }
+    }
+
+    // the SEED_CANDIDATES most frequent, highest count first and lowest code among equals
+    vector<pair<uint32_t, uint64_t>> top;
+    for (size_t x = 0; x < cells; ++x) {
+        if (counts[x] == 0 || (top.size() == SEED_CANDIDATES && counts[x] <= top.back().first)) {
+            continue;
+        }
+        if (top.size() == SEED_CANDIDATES) {
+            top.pop_back();
+        }
+        auto at = upper_bound(top.begin(), top.end(), counts[x],
+                              [](uint32_t count, const pair<uint32_t, uint64_t>& entry) { return count > entry.first; });
+        top.insert(at, {counts[x], x});
+    }
+
+    // k-mers longer than the table are ranked by their first L positions; the candidate is
+    // the first whole window starting with one of those
+    vector<uint64_t> candidates;
+    for (const auto& entry : top) {
+        candidates.push_back(entry.second);
+    }
+    if (K > L) {
+        vector<bool> found(candidates.size(), false);
+        for (const auto& seq : sequences) {
+            for (size_t p = 0; p + K <= seq.length; ++p) {
+                uint64_t prefix = packedWindow(seq.bits, p, L);
+                for (size_t c = 0; c < candidates.size(); ++c) {
+                    if (!found[c] && (candidates[c] & kmerMask(L)) == prefix) {
+                        candidates[c] = packedWindow(seq.bits, p, K);
+                        found[c] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    uint64_t bestKmer = 0;
+    int bestDistance = INT_MAX;
+    for (uint64_t kmer : candidates) {
+        int distance = distanceTotal(kmer, K, sequences, bestDistance);
+        if (distance < bestDistance) {
+            bestKmer = kmer;
+            bestDistance = distance;
+        }
+    }
+    return decodeKmer(bestKmer, K);
+}
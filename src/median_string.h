@@ -0,0 +1,30 @@
+#ifndef MEDIAN_STRING_MEDIAN_STRING_H
+#define MEDIAN_STRING_MEDIAN_STRING_H
+
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packed_sequence.h"
+
+
+// minimum Hamming distance between the packed L-length k-mer and any window of seq. the scan
+// ends at the first exact match
+int distanceToSequence(uint64_t kmer, int L, const PackedSequence& seq);
+
+// sum of distanceToSequence over all sequences. stops as soon as the sum reaches cutoff and
+// returns that partial sum, so any result >= cutoff only says the k-mer is no better
+int distanceTotal(uint64_t kmer, int L, const std::vector<PackedSequence>& sequences, int cutoff = INT_MAX);
+
+// k-mers up to this length are counted in a flat 4^K table of 32-bit counts per thread;
+// longer ones are counted by their first MAX_SEED_COUNT_K positions
+const int MAX_SEED_COUNT_K = 11;
+// most frequent k-mers HeuristicKmer scores in full
+const size_t SEED_CANDIDATES = 8;
+
+// starting k-mer: the SEED_CANDIDATES most frequent ACGT-only windows of the input, counted
+// exactly, with the one closest to all sequences kept. deterministic; threads split the count
+std::string HeuristicKmer(const std::vector<PackedSequence>& sequences, int K, int threads = 1);
+
+#endif
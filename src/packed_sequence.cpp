@@ -0,0 +1,90 @@
+#include "packed_sequence.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+
+namespace {
+
+// encodeNT for every byte value, so appends do one lookup per character
+struct CodeTable {
+    int8_t codes[256];
+    CodeTable() {
+        for (int c = 0; c < 256; ++c) {
+            codes[c] = static_cast<int8_t>(encodeNT(static_cast<char>(c)));
+        }
+    }
+};
+const CodeTable codeTable;
+
+}
+
+
+void appendSequence(PackedSequence& packed, const char* data, size_t n) {
+    size_t start = packed.length;
+    size_t words = (start + n) / 32 + 2;
+    packed.bits.resize(words, 0);
+    if (packed.hasInvalid) {
+        packed.invalid.resize(words, 0);
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = start + k;
+        int code = codeTable.codes[static_cast<unsigned char>(data[k])];
+        if (code < 0) {
+            // allocate the invalid plane lazily; most inputs never need it
+            if (!packed.hasInvalid) {
+                packed.invalid.assign(words, 0);
+                packed.hasInvalid = true;
+            }
+            packed.invalid[i >> 5] |= 1ULL << ((i & 31) * 2);
+            continue;
+        }
+        packed.bits[i >> 5] |= static_cast<uint64_t>(code) << ((i & 31) * 2);
+    }
+    packed.length = start + n;
+}
+
+
+PackedSequence encodeSequence(const string& seq) {
+    PackedSequence packed;
+    appendSequence(packed, seq.data(), seq.length());
+    return packed;
+}
+
+
+uint64_t encodeKmer(const string& kmer, int L) {
+    if (L > 32 || kmer.length() < static_cast<size_t>(L)) {
+        throw invalid_argument("k-mer does not fit in a packed word");
+    }
+    uint64_t word = 0;
+    for (int i = 0; i < L; ++i) {
+        int code = encodeNT(kmer[i]);
+        if (code < 0) {
+            throw invalid_argument("k-mer contains a non-ACGT character");
+        }
+        word |= static_cast<uint64_t>(code) << (2 * i);
+    }
+    return word;
+}
+
+
+string decodeKmer(uint64_t kmer, int L) {
+    static const char alphabet[] = {'A', 'C', 'G', 'T'};
+    string str(L, 'A');
+    for (int i = 0; i < L; ++i) {
+        str[i] = alphabet[(kmer >> (2 * i)) & 3];
+    }
+    return str;
+}
+
+
+vector<uint8_t> unpackSequence(const PackedSequence& seq) {
+    vector<uint8_t> codes(seq.length);
+    for (size_t i = 0; i < seq.length; ++i) {
+        int code = ntCodeOrInvalid(seq, i);
+        codes[i] = code < 0 ? INVALID_CODE : static_cast<uint8_t>(code);
+    }
+    return codes;
+}
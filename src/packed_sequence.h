@@ -0,0 +1,92 @@
+#ifndef MEDIAN_STRING_PACKED_SEQUENCE_H
+#define MEDIAN_STRING_PACKED_SEQUENCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// 2-bit nucleotide codes: A=0, C=1, G=2, T=3. any other character is stored as A
+// and flagged in the invalid plane so it mismatches every k-mer position, like the
+// byte comparison it replaces
+const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+
+// sequence encoded once at load time. nucleotide i lives in bits [2*(i%32), 2*(i%32)+1]
+// of word i/32, so a k-mer (k <= 32) is a single machine word with its first nucleotide
+// in the low bits. both planes carry one zero word of padding so window reads never
+// need a bounds check
+struct PackedSequence {
+    size_t length = 0;
+    std::vector<uint64_t> bits;
+    // 0b01 at every non-ACGT position, same layout as bits. empty when hasInvalid is false
+    std::vector<uint64_t> invalid;
+    bool hasInvalid = false;
+};
+
+
+// 2-bit code of a nucleotide, or -1 for anything outside A,C,G,T
+inline int encodeNT(char c) {
+    switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+    }
+}
+
+// longest k-mer that still packs into one word
+const int MAX_KMER_LENGTH = 32;
+
+// mask covering the 2*L low bits of a packed k-mer
+inline uint64_t kmerMask(int L) {
+    return L >= 32 ? ~0ULL : (1ULL << (2 * L)) - 1;
+}
+
+// number of mismatching positions between two packed k-mers of equal length
+inline int hammingDistance(uint64_t kmer1, uint64_t kmer2) {
+    uint64_t x = kmer1 ^ kmer2;
+    return __builtin_popcountll((x | (x >> 1)) & EVEN_BITS);
+}
+
+// read 2*L bits starting at nucleotide pos from a packed plane
+inline uint64_t packedWindow(const std::vector<uint64_t>& plane, size_t pos, int L) {
+    size_t bit = 2 * pos;
+    size_t q = bit >> 6;
+    unsigned s = bit & 63;
+    // split shift keeps s == 0 well defined
+    uint64_t word = (plane[q] >> s) | ((plane[q + 1] << 1) << (63 - s));
+    return word & kmerMask(L);
+}
+
+// 2-bit code of the nucleotide at pos (invalid positions read as A)
+inline int ntCode(const PackedSequence& seq, size_t pos) {
+    return (seq.bits[pos >> 5] >> ((pos & 31) * 2)) & 3;
+}
+
+
+// 2-bit code of the nucleotide at pos, or -1 if it is not A, C, G or T
+inline int ntCodeOrInvalid(const PackedSequence& seq, size_t pos) {
+    if (seq.hasInvalid && ((seq.invalid[pos >> 5] >> ((pos & 31) * 2)) & 1)) {
+        return -1;
+    }
+    return ntCode(seq, pos);
+}
+
+
+PackedSequence encodeSequence(const std::string& seq);
+
+// encode n more characters onto the end of packed, keeping the padding word in place
+void appendSequence(PackedSequence& packed, const char* data, size_t n);
+
+// pack the first L characters of a k-mer string; throws on non-ACGT characters
+uint64_t encodeKmer(const std::string& kmer, int L);
+std::string decodeKmer(uint64_t kmer, int L);
+
+// one byte per nucleotide: codes 0..3, non-ACGT positions as INVALID_CODE
+const uint8_t INVALID_CODE = 4;
+std::vector<uint8_t> unpackSequence(const PackedSequence& seq);
+
+#endif
@@ -0,0 +1,151 @@
+#include "parallel_search.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "lower_bound.h"
+
+using namespace std;
+
+
+namespace {
+
+// subtrees owned by one worker. the owner takes from the back, thieves from the front, so
+// the owner walks its share in DFS order while thieves carry off the far end of it
+class TaskDeque {
+public:
+    void push(uint64_t prefix) {
+        lock_guard<mutex> lock(m);
+        tasks.push_back(prefix);
+    }
+
+    bool pop(uint64_t& prefix) {
+        lock_guard<mutex> lock(m);
+        if (tasks.empty()) {
+            return false;
+        }
+        prefix = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+    bool steal(uint64_t& prefix) {
+        lock_guard<mutex> lock(m);
+        if (tasks.empty()) {
+            return false;
+        }
+        prefix = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+
+private:
+    mutex m;
+    deque<uint64_t> tasks;
+};
+
+
+// replay a task prefix on the worker's own state, then search below it
+void runTask(const WindowIndex& index, PrefixState& state, SharedIncumbent& incumbent, const BoundSet* bounds,
+             int worker, uint64_t prefix, int splitDepth) {
+    int distance = 0;
+    WorkerStats* counters = nullptr;
+    STATS_ONLY(counters = &incumbent.stats->worker(worker);)
+    for (int iter = 0; iter < splitDepth; ++iter) {
+        distance = extendPrefix(index, state, iter, (prefix >> (2 * iter)) & 3, incumbent.bound(), counters);
+        // replayed prefixes count as nodes too; tasks share them, so shallow depths read high
+        STATS_ONLY(WorkerStats& stats = *counters;)
+        if (distance >= incumbent.bound() || incumbent.proven()) {
+            STATS_ONLY(stats.nodes[iter + 1]++;)
+            STATS_ONLY(stats.pruned[iter + 1]++;)
+            return;
+        }
+        // the last replayed prefix is counted by branch_and_bound itself
+        STATS_ONLY(stats.nodes[iter + 1] += iter + 1 < splitDepth;)
+    }
+    uint64_t currentKmer = prefix;
+    branch_and_bound(index, state, currentKmer, incumbent, bounds, worker, splitDepth, distance);
+}
+
+
+void worker(const WindowIndex& index, vector<TaskDeque>& queues, SharedIncumbent& incumbent, const BoundSet* bounds,
+            int id, int splitDepth) {
+    PrefixState state = makePrefixState(index);
+    int workers = static_cast<int>(queues.size());
+    uint64_t prefix;
+
+    while (true) {
+        if (queues[id].pop(prefix)) {
+            runTask(index, state, incumbent, bounds, id, prefix, splitDepth);
+            continue;
+        }
+        // own share exhausted; tasks never spawn new ones, so a full empty sweep means done
+        bool stolen = false;
+        for (int k = 1; k < workers && !stolen; ++k) {
+            stolen = queues[(id + k) % workers].steal(prefix);
+        }
+        if (!stolen) {
+            return;
+        }
+        runTask(index, state, incumbent, bounds, id, prefix, splitDepth);
+    }
+}
+
+}
+
+
+int maxSplitDepth(const WindowIndex& index) {
+    return max(index.K - index.tailLength, 1);
+}
+
+
+int defaultSplitDepth(int levels, int threads) {
+    int depth = 1;
+    while (depth < levels && (1ULL << (2 * depth)) < 16ULL * threads) {
+        depth++;
+    }
+    return depth;
+}
+
+
+void parallel_branch_and_bound(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance,
+                               int threads, int splitDepth, int floor, const BoundSet* bounds) {
+    int K = index.K;
+    threads = max(threads, 1);
+    // a task below the tail level would never meet it and enumerate the tail node by node
+    splitDepth = min(max(splitDepth, 1), maxSplitDepth(index));
+
+    SharedIncumbent incumbent(threads, bestKmer, bestDistance, floor);
+    STATS_ONLY(SearchStats stats("parallel_bnb", K, threads);)
+    STATS_ONLY(if (bounds) stats.setBounds(bounds->names());)
+    STATS_ONLY(incumbent.stats = &stats;)
+
+    // hand out contiguous runs of prefixes in lexicographic order. codes are stored from the
+    // low bits, so prefix p of the enumeration is built most significant position first
+    uint64_t tasks = 1ULL << (2 * splitDepth);
+    vector<TaskDeque> queues(threads);
+    for (int w = 0; w < threads; ++w) {
+        uint64_t first = tasks * w / threads;
+        uint64_t last = tasks * (w + 1) / threads;
+        for (uint64_t t = last; t-- > first;) {
+            uint64_t prefix = 0;
+            for (int iter = 0; iter < splitDepth; ++iter) {
+                prefix |= ((t >> (2 * (splitDepth - 1 - iter))) & 3) << (2 * iter);
+            }
+            queues[w].push(prefix);
+        }
+    }
+
+    vector<thread> pool;
+    for (int w = 0; w < threads; ++w) {
+        pool.emplace_back(worker, cref(index), ref(queues), ref(incumbent), bounds, w, splitDepth);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    bestDistance = incumbent.best(bestKmer, K);
+    STATS_ONLY(stats.finish(bestDistance);)
+}
@@ -0,0 +1,23 @@
+#ifndef MEDIAN_STRING_PARALLEL_SEARCH_H
+#define MEDIAN_STRING_PARALLEL_SEARCH_H
+
+#include <cstdint>
+
+#include "search.h"
+
+
+// deepest split parallel_branch_and_bound takes: the levels above index's tail solve, which
+// the workers only reach at exactly K - tailLength
+int maxSplitDepth(const WindowIndex& index);
+
+// smallest split depth up to levels giving every worker a few dozen subtrees to balance with
+int defaultSplitDepth(int levels, int threads);
+
+// branch and bound on threads workers. every prefix of length splitDepth, at most
+// maxSplitDepth(index), becomes a task on a work-stealing scheduler and all workers prune
+// against one shared incumbent. bestKmer/bestDistance carry the starting incumbent in and
+// the optimum out; floor and bounds as for branch_and_bound
+void parallel_branch_and_bound(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance,
+                               int threads, int splitDepth, int floor = 0, const BoundSet* bounds = nullptr);
+
+#endif
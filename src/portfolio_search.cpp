@@ -0,0 +1,71 @@
+#include "portfolio_search.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "lower_bound.h"
+
+using namespace std;
+
+
+namespace {
+
+bool sameOrder(const ChildOrder& a, const ChildOrder& b) {
+    return a.bestChildFirst == b.bestChildFirst && equal(a.codes, a.codes + 4, b.codes);
+}
+
+// child order of member m. member 0 keeps the configured order; the others cycle through the
+// four rotations of A, C, G, T, which start in different quarters of the tree, first plain
+// and then with the closest child first. a rotation that is the configured order would only
+// repeat member 0's search, so it is left out
+ChildOrder memberOrder(const WindowIndex& index, int member) {
+    if (member == 0) {
+        return index.childOrder;
+    }
+    vector<ChildOrder> others;
+    for (int variant = 0; variant < 8; ++variant) {
+        ChildOrder order;
+        for (int i = 0; i < 4; ++i) {
+            order.codes[i] = static_cast<uint8_t>((i + variant % 4) % 4);
+        }
+        order.bestChildFirst = variant >= 4;
+        if (!sameOrder(order, index.childOrder)) {
+            others.push_back(order);
+        }
+    }
+    return others[(member - 1) % others.size()];
+}
+
+
+void runMember(const WindowIndex& index, SharedIncumbent& incumbent, const BoundSet* bounds, int member) {
+    PrefixState state = makePrefixState(index);
+    state.childOrder = memberOrder(index, member);
+    uint64_t currentKmer = 0;
+    branch_and_bound(index, state, currentKmer, incumbent, bounds, member, 0, 0);
+    // nothing below the incumbent is left anywhere in the tree
+    incumbent.prove();
+}
+
+}
+
+
+void portfolio_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, int members,
+                      int floor, const BoundSet* bounds) {
+    members = max(members, 1);
+    SharedIncumbent incumbent(members, bestKmer, bestDistance, floor);
+    STATS_ONLY(SearchStats stats("portfolio", index.K, members);)
+    STATS_ONLY(if (bounds) stats.setBounds(bounds->names());)
+    STATS_ONLY(incumbent.stats = &stats;)
+
+    vector<thread> pool;
+    for (int m = 0; m < members; ++m) {
+        pool.emplace_back(runMember, cref(index), ref(incumbent), bounds, m);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    bestDistance = incumbent.best(bestKmer, index.K);
+    STATS_ONLY(stats.finish(bestDistance);)
+}
@@ -0,0 +1,16 @@
+#ifndef MEDIAN_STRING_PORTFOLIO_SEARCH_H
+#define MEDIAN_STRING_PORTFOLIO_SEARCH_H
+
+#include <cstdint>
+
+#include "search.h"
+
+
+// members complete depth-first searches of the whole tree run side by side, each visiting
+// children in its own order and all pruning against one shared incumbent, so an improvement
+// any of them finds tightens the others. the first to finish has proven the incumbent
+// optimal and stops the rest. bestKmer/bestDistance, floor and bounds as for branch_and_bound
+void portfolio_search(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, int members,
+                      int floor = 0, const BoundSet* bounds = nullptr);
+
+#endif
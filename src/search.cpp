@@ -0,0 +1,699 @@
+#include "search.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "lower_bound.h"
+
+using namespace std;
+
+
+WindowIndex buildWindowIndex(const vector<PackedSequence>& sequences, int K) {
+    WindowIndex index;
+    index.K = K;
+    for (const auto& seq : sequences) {
+        size_t windows = seq.length >= static_cast<size_t>(K) ? seq.length - K + 1 : 0;
+        index.codes.push_back(unpackSequence(seq));
+        index.strides.push_back(1);
+        index.windows.push_back(windows);
+        index.offsets.push_back(index.totalWindows);
+        index.totalWindows += windows;
+    }
+    return index;
+}
+
+
+WindowIndex buildWindowIndex(const vector<KmerSummary>& summaries) {
+    WindowIndex index;
+    for (const auto& summary : summaries) {
+        appendToWindowIndex(index, summary);
+    }
+    return index;
+}
+
+
+void appendToWindowIndex(WindowIndex& index, const KmerSummary& summary) {
+    if (index.K != 0 && index.K != summary.K) {
+        throw invalid_argument("summary k-mer length does not match the index");
+    }
+    index.K = summary.K;
+    int K = summary.K;
+    // the tail tables no longer cover every window
+    prepareTailSolve(index, 0);
+
+    vector<uint64_t> kmers;
+    for (size_t w = 0; w < summary.presence.size(); ++w) {
+        for (uint64_t bits = summary.presence[w]; bits; bits &= bits - 1) {
+            kmers.push_back(w * 64 + __builtin_ctzll(bits));
+        }
+    }
+    size_t windows = kmers.size() + summary.invalidWindows.size();
+
+    // one plane per k-mer position, window-major inside a plane
+    vector<uint8_t> codes(windows * K);
+    for (int j = 0; j < K; ++j) {
+        uint8_t* plane = codes.data() + j * windows;
+        for (size_t w = 0; w < kmers.size(); ++w) {
+            plane[w] = (kmers[w] >> (2 * j)) & 3;
+        }
+        for (size_t w = 0; w < summary.invalidWindows.size(); ++w) {
+            const auto& window = summary.invalidWindows[w];
+            bool bad = (window.second >> (2 * j)) & 1;
+            plane[kmers.size() + w] = bad ? INVALID_CODE : (window.first >> (2 * j)) & 3;
+        }
+    }
+
+    index.codes.push_back(move(codes));
+    index.strides.push_back(windows);
+    index.windows.push_back(windows);
+    index.offsets.push_back(index.totalWindows);
+    index.totalWindows += windows;
+}
+
+
+WindowIndex suffixWindowIndex(const WindowIndex& index, int L) {
+    WindowIndex suffix;
+    suffix.K = L;
+    suffix.strides = index.strides;
+    suffix.windows = index.windows;
+    suffix.offsets = index.offsets;
+    suffix.totalWindows = index.totalWindows;
+    size_t skip = index.K - L;
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        // planes are stride apart, so dropping the first K - L planes is dropping a prefix
+        const vector<uint8_t>& codes = index.codes[s];
+        size_t begin = min(skip * index.strides[s], codes.size());
+        suffix.codes.emplace_back(codes.begin() + begin, codes.end());
+    }
+    return suffix;
+}
+
+
+int indexDistance(const WindowIndex& index, uint64_t kmer) {
+    int total = 0;
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        int best = index.K;
+        for (size_t w = 0; w < index.windows[s] && best > 0; ++w) {
+            // a window stops counting as soon as it cannot beat the best one
+            int count = 0;
+            for (int j = 0; j < index.K && count < best; ++j) {
+                count += index.plane(s, j)[w] != ((kmer >> (2 * j)) & 3);
+            }
+            best = min(best, count);
+        }
+        total += best;
+    }
+    return total;
+}
+
+
+void prepareTailSolve(WindowIndex& index, int length) {
+    int K = index.K;
+    size_t sequences = index.codes.size();
+    int L = min({length, K - 1, MAX_TAIL_LENGTH});
+    if (length < 0) {
+        // one solve replaces 4^L leaves and early exits on the bound, so it pays off even at
+        // many window passes per call. short tails cost more than the levels they replace
+        L = min(K - 1, MAX_TAIL_LENGTH);
+        while (L > 0 && sequences << (2 * L) > 64 * index.totalWindows) {
+            L--;
+        }
+        if (L < 3) {
+            L = 0;
+        }
+    }
+    index.tailLength = max(L, 0);
+    index.tailCodes.clear();
+    index.invalidTails.clear();
+    index.tailLexOrder.clear();
+    if (index.tailLength == 0) {
+        return;
+    }
+    L = index.tailLength;
+
+    index.tailCodes.resize(index.totalWindows);
+    index.invalidTails.resize(sequences);
+    for (size_t s = 0; s < sequences; ++s) {
+        map<pair<uint16_t, uint16_t>, size_t> groups;
+        for (size_t w = 0; w < index.windows[s]; ++w) {
+            uint16_t kmer = 0;
+            uint16_t invalid = 0;
+            for (int j = 0; j < L; ++j) {
+                uint8_t code = index.plane(s, K - L + j)[w];
+                if (code == INVALID_CODE) {
+                    invalid |= 1 << (2 * j);
+                } else {
+                    kmer |= code << (2 * j);
+                }
+            }
+            if (!invalid) {
+                index.tailCodes[index.offsets[s] + w] = kmer;
+                continue;
+            }
+            index.tailCodes[index.offsets[s] + w] = INVALID_TAIL;
+            auto found = groups.emplace(make_pair(kmer, invalid), index.invalidTails[s].size());
+            if (found.second) {
+                index.invalidTails[s].push_back({kmer, invalid, {}});
+            }
+            index.invalidTails[s][found.first->second].windows.push_back(static_cast<uint32_t>(w));
+        }
+    }
+
+    // packed tails keep their first code in the low bits; lexicographic order reads it first
+    size_t size = 1ULL << (2 * L);
+    for (size_t rank = 0; rank < size; ++rank) {
+        uint16_t kmer = 0;
+        for (int j = 0; j < L; ++j) {
+            kmer |= ((rank >> (2 * (L - 1 - j))) & 3) << (2 * j);
+        }
+        index.tailLexOrder.push_back(kmer);
+    }
+}
+
+
+bool isChildOrder(const string& order) {
+    return order == "fixed" || order == "frequency" || order == "best";
+}
+
+
+void prepareChildOrder(WindowIndex& index, const string& order) {
+    if (!isChildOrder(order)) {
+        throw invalid_argument("unknown child order '" + order + "' (expected fixed, frequency or best)");
+    }
+    index.childOrder = ChildOrder();
+    index.childOrder.bestChildFirst = order == "best";
+    // best breaks ties in A, C, G, T order like every other engine, so the median reported
+    // among equally close k-mers does not depend on which engine ran
+    if (order != "frequency") {
+        return;
+    }
+
+    // first position of every window: the whole sequence bar its last K - 1 nucleotides
+    size_t counts[INVALID_CODE + 1] = {};
+    for (size_t s = 0; s < index.codes.size(); ++s) {
+        const uint8_t* nt = index.plane(s, 0);
+        for (size_t w = 0; w < index.windows[s]; ++w) {
+            counts[nt[w]]++;
+        }
+    }
+    uint8_t* codes = index.childOrder.codes;
+    stable_sort(codes, codes + 4, [&](uint8_t a, uint8_t b) { return counts[a] > counts[b]; });
+}
+
+
+namespace {
+
+// count one scan from the depth of order, re-sorting when its interval is up
+void finishScan(const WindowIndex& index, SequenceOrder& order) {
+    if (!index.adaptiveOrder || ++order.scans % SEQUENCE_REORDER_INTERVAL != 0) {
+        return;
+    }
+    // the +1s keep an unsampled sequence in the running until it has been seen
+    size_t sequences = order.order.size();
+    vector<double> score(sequences);
+    for (size_t s = 0; s < sequences; ++s) {
+        score[s] = (order.gains[s] + 1.0) / (order.samples[s] + 1.0) / max<size_t>(index.windows[s], 1);
+        order.gains[s] /= 2;
+        order.samples[s] /= 2;
+    }
+    stable_sort(order.order.begin(), order.order.end(), [&](uint32_t a, uint32_t b) { return score[a] > score[b]; });
+}
+
+
+// windows sampled to decide whether compacting a dense row is worth a pass
+const size_t COMPACT_SAMPLE = 64;
+// windows compactRow tests at once
+const size_t COMPACT_BLOCK = 64;
+
+// list the windows of a dense row below threshold in ids and pack their counts at the front
+// of counts, if there are few enough of them. returns their number, or DENSE_ROW with the
+// row untouched
+uint32_t compactRow(uint8_t* counts, uint32_t* ids, size_t windows, uint8_t threshold) {
+    size_t sampled = 0;
+    for (size_t w = 0; w < windows; w += COMPACT_SAMPLE) {
+        sampled += counts[w] < threshold;
+    }
+    if (sampled * COMPACT_SAMPLE * COMPACT_RATIO > windows) {
+        return DENSE_ROW;
+    }
+    // the sample can be off, so the list may still overflow its slot. blocks without an
+    // active window are skipped by a vectorized test; the others are listed without a
+    // branch per window, which may write up to a block past the list
+    size_t capacity = windows / COMPACT_RATIO + 1;
+    size_t size = 0;
+    for (size_t begin = 0; begin < windows; begin += COMPACT_BLOCK) {
+        size_t end = min(windows, begin + COMPACT_BLOCK);
+        uint8_t lowest = UINT8_MAX;
+        for (size_t w = begin; w < end; ++w) {
+            lowest = min(lowest, counts[w]);
+        }
+        if (lowest >= threshold) {
+            continue;
+        }
+        for (size_t w = begin; w < end; ++w) {
+            ids[size] = static_cast<uint32_t>(w);
+            size += counts[w] < threshold;
+        }
+        if (size > capacity) {
+            return DENSE_ROW;
+        }
+    }
+    // ids[i] >= i, so the packing never overwrites a count it still needs
+    for (size_t i = 0; i < size; ++i) {
+        counts[i] = counts[ids[i]];
+    }
+    return static_cast<uint32_t>(size);
+}
+
+}
+
+
+PrefixState makePrefixState(const WindowIndex& index) {
+    PrefixState state;
+    state.childOrder = index.childOrder;
+    SequenceOrder start;
+    size_t sequences = index.codes.size();
+    for (size_t s = 0; s < sequences; ++s) {
+        start.order.push_back(static_cast<uint32_t>(s));
+    }
+    if (index.adaptiveOrder) {
+        stable_sort(start.order.begin(), start.order.end(),
+                    [&](uint32_t a, uint32_t b) { return index.windows[a] < index.windows[b]; });
+    }
+    start.gains.assign(sequences, 0);
+    start.samples.assign(sequences, 0);
+    state.sequenceOrders.assign(index.K + 1, start);
+    // row 0 is the empty prefix: zero mismatches everywhere
+    state.depthCounts.assign(index.K + 1, vector<uint8_t>(index.totalWindows, 0));
+    state.minima.assign(index.K + 1, vector<uint8_t>(sequences, 0));
+    state.activeSizes.assign(index.K + 1, vector<uint32_t>(sequences, DENSE_ROW));
+    // a sparse row never holds more than windows / COMPACT_RATIO ids of a sequence; compactRow
+    // may write a block past that
+    size_t capacity = 0;
+    for (size_t s = 0; s < sequences; ++s) {
+        state.activeOffsets.push_back(capacity);
+        capacity += index.windows[s] / COMPACT_RATIO + 1 + COMPACT_BLOCK;
+    }
+    state.activeIds.assign(index.K + 1, vector<uint32_t>(capacity));
+    if (index.tailLength > 0) {
+        state.tailTable.resize(1ULL << (2 * index.tailLength));
+        state.tailTotals.resize(1ULL << (2 * index.tailLength));
+    }
+    return state;
+}
+
+
+int extendPrefix(const WindowIndex& index, PrefixState& state, int iter, int code, int limit, WorkerStats* stats) {
+    uint8_t* child = state.depthCounts[iter + 1].data();
+    uint32_t* childIds = state.activeIds[iter + 1].data();
+    uint8_t c = static_cast<uint8_t>(code);
+    int open = index.K - iter;
+
+    SequenceOrder& order = state.sequenceOrders[iter];
+    int total = 0;
+    for (uint32_t s : order.order) {
+        const uint8_t* nt = index.plane(s, iter);
+        ActiveWindows parent = activeWindows(index, state, iter, s);
+        const uint8_t* in = parent.counts;
+        uint8_t* out = child + index.offsets[s];
+        uint32_t* ids = childIds + state.activeOffsets[s];
+        // the child's minimum is at most one above the parent's, and the open positions drop
+        // by one, so a window at this count or above is out for good
+        uint8_t threshold = static_cast<uint8_t>(min(state.minima[iter][s] + open, int(UINT8_MAX)));
+        uint8_t minCount = UINT8_MAX;
+        uint32_t size = 0;
+        if (!parent.ids) {
+            size_t windows = parent.size;
+            for (size_t w = 0; w < windows; ++w) {
+                uint8_t count = in[w] + (nt[w] != c);
+                out[w] = count;
+                minCount = min(minCount, count);
+            }
+            size = compactRow(out, ids, windows, threshold);
+        } else {
+            for (size_t i = 0; i < parent.size; ++i) {
+                uint32_t w = parent.ids[i];
+                uint8_t count = in[i] + (nt[w] != c);
+                minCount = min(minCount, count);
+                ids[size] = w;
+                out[size] = count;
+                size += count < threshold;
+            }
+        }
+        state.activeSizes[iter + 1][s] = size;
+        state.minima[iter + 1][s] = minCount;
+        total += minCount;
+        order.gains[s] += minCount;
+        order.samples[s]++;
+        if (stats) {
+            stats->windows += parent.size;
+        }
+        if (total >= limit) {
+            break;
+        }
+    }
+    finishScan(index, order);
+    return total;
+}
+
+
+void scoreChildren(const WindowIndex& index, PrefixState& state, int iter, int distances[4],
+                   int limit, WorkerStats* stats) {
+    SequenceOrder& order = state.sequenceOrders[iter];
+    fill(distances, distances + 4, 0);
+    for (uint32_t s : order.order) {
+        const uint8_t* nt = index.plane(s, iter);
+        ActiveWindows active = activeWindows(index, state, iter, s);
+        const uint8_t* in = active.counts;
+        size_t windows = active.size;
+        uint8_t m0 = UINT8_MAX, m1 = UINT8_MAX, m2 = UINT8_MAX, m3 = UINT8_MAX;
+        size_t end = 0;
+        if (active.ids) {
+            for (size_t i = 0; i < windows; ++i) {
+                uint8_t a = in[i];
+                uint8_t n = nt[active.ids[i]];
+                m0 = min(m0, static_cast<uint8_t>(a + (n != 0)));
+                m1 = min(m1, static_cast<uint8_t>(a + (n != 1)));
+                m2 = min(m2, static_cast<uint8_t>(a + (n != 2)));
+                m3 = min(m3, static_cast<uint8_t>(a + (n != 3)));
+            }
+            end = windows;
+        }
+        while (end < windows) {
+            size_t begin = end;
+            end = min(windows, begin + EXIT_CHECK_WINDOWS);
+            for (size_t w = begin; w < end; ++w) {
+                uint8_t a = in[w];
+                uint8_t n = nt[w];
+                m0 = min(m0, static_cast<uint8_t>(a + (n != 0)));
+                m1 = min(m1, static_cast<uint8_t>(a + (n != 1)));
+                m2 = min(m2, static_cast<uint8_t>(a + (n != 2)));
+                m3 = min(m3, static_cast<uint8_t>(a + (n != 3)));
+            }
+            // no child can do better on this sequence
+            if ((m0 | m1 | m2 | m3) == 0) {
+                break;
+            }
+        }
+        distances[0] += m0;
+        distances[1] += m1;
+        distances[2] += m2;
+        distances[3] += m3;
+        // what the sequence adds to every child
+        order.gains[s] += min(min(m0, m1), min(m2, m3));
+        order.samples[s]++;
+        if (stats) {
+            stats->windows += end;
+        }
+        if (min(min(distances[0], distances[1]), min(distances[2], distances[3])) >= limit) {
+            break;
+        }
+    }
+    finishScan(index, order);
+}
+
+
+namespace {
+
+// one axis of the min-plus sweep over a table of SIZE cells: every run of four cells STRIDE
+// apart takes the minimum of the four plus one
+template <size_t STRIDE, size_t SIZE>
+void sweepAxis(uint8_t* table) {
+    for (size_t base = 0; base < SIZE; base += 4 * STRIDE) {
+        uint8_t* v0 = table + base;
+        uint8_t* v1 = v0 + STRIDE;
+        uint8_t* v2 = v1 + STRIDE;
+        uint8_t* v3 = v2 + STRIDE;
+        for (size_t r = 0; r < STRIDE; ++r) {
+            uint8_t m = min(min(v0[r], v1[r]), min(v2[r], v3[r])) + 1;
+            v0[r] = min(v0[r], m);
+            v1[r] = min(v1[r], m);
+            v2[r] = min(v2[r], m);
+            v3[r] = min(v3[r], m);
+        }
+    }
+}
+
+// the same min-plus sweep as the hypercube engine, one axis per tail position
+template <int L, size_t... J>
+void sweepTable(uint8_t* table, index_sequence<J...>) {
+    (sweepAxis<1ULL << (2 * J), 1ULL << (2 * L)>(table), ...);
+}
+
+
+// solveTail for a tail of L. with L a constant the table size and every stride of the sweep
+// are too, so the short axes unroll instead of running one-cell loops
+template <int L>
+int solveTailFor(const WindowIndex& index, PrefixState& state, int iter, int limit, uint64_t& tail,
+                 WorkerStats* stats, const function<void(size_t)>& fillRow) {
+    const size_t size = 1ULL << (2 * L);
+    uint8_t* table = state.tailTable.data();
+    uint32_t* totals = state.tailTotals.data();
+    fill(totals, totals + size, 0);
+
+    // cells no window reaches start well above any real count (at most K + L) and far
+    // enough below 255 that the sweep's +1 cannot wrap
+    const uint8_t unreached = 127;
+    // a window with non-ACGT tail codes mismatches there whatever the tail is: it acts like
+    // every ACGT filling of those positions, each costing their count more
+    auto spread = [&](uint16_t kmer, uint16_t invalid, uint8_t count) {
+        count += __builtin_popcount(invalid);
+        uint16_t open = invalid | (invalid << 1);
+        uint16_t filling = 0;
+        do {
+            uint16_t cell = kmer | filling;
+            table[cell] = min(table[cell], count);
+            filling = (filling - open) & open;
+        } while (filling);
+    };
+    SequenceOrder& order = state.sequenceOrders[iter];
+    for (uint32_t s : order.order) {
+        if (fillRow) {
+            fillRow(s);
+        }
+        ActiveWindows active = activeWindows(index, state, iter, s);
+        const uint8_t* counts = active.counts;
+        const uint16_t* codes = index.tailCodes.data() + index.offsets[s];
+        fill(table, table + size, unreached);
+        if (!active.ids) {
+            for (size_t w = 0; w < active.size; ++w) {
+                if (codes[w] != INVALID_TAIL) {
+                    table[codes[w]] = min(table[codes[w]], counts[w]);
+                }
+            }
+            for (const auto& group : index.invalidTails[s]) {
+                uint8_t best = UINT8_MAX;
+                for (uint32_t w : group.windows) {
+                    best = min(best, counts[w]);
+                }
+                spread(group.kmer, group.invalid, best);
+            }
+        } else {
+            // few windows are left, so the odd invalid one is spread on its own
+            for (size_t i = 0; i < active.size; ++i) {
+                uint32_t w = active.ids[i];
+                if (codes[w] != INVALID_TAIL) {
+                    table[codes[w]] = min(table[codes[w]], counts[i]);
+                    continue;
+                }
+                uint16_t kmer = 0;
+                uint16_t invalid = 0;
+                for (int j = 0; j < L; ++j) {
+                    uint8_t code = index.plane(s, index.K - L + j)[w];
+                    if (code == INVALID_CODE) {
+                        invalid |= 1 << (2 * j);
+                    } else {
+                        kmer |= code << (2 * j);
+                    }
+                }
+                spread(kmer, invalid, counts[i]);
+            }
+        }
+
+        sweepTable<L>(table, make_index_sequence<L>());
+
+        // totals only grow, so once every cell reaches limit no tail can beat it
+        uint32_t lowest = UINT32_MAX;
+        uint8_t added = UINT8_MAX;
+        for (size_t x = 0; x < size; ++x) {
+            totals[x] += table[x];
+            lowest = min(lowest, totals[x]);
+            added = min(added, table[x]);
+        }
+        order.gains[s] += added;
+        order.samples[s]++;
+        if (stats) {
+            stats->windows += active.size;
+        }
+        if (lowest >= static_cast<uint32_t>(limit)) {
+            finishScan(index, order);
+            return limit;
+        }
+    }
+    finishScan(index, order);
+
+    uint32_t best = UINT32_MAX;
+    for (uint16_t x : index.tailLexOrder) {
+        if (totals[x] < best) {
+            best = totals[x];
+            tail = x;
+        }
+    }
+    return static_cast<int>(best);
+}
+
+}
+
+
+int solveTail(const WindowIndex& index, PrefixState& state, int iter, int limit, uint64_t& tail,
+              WorkerStats* stats, const function<void(size_t)>& fillRow) {
+    using TailSolve = int (*)(const WindowIndex&, PrefixState&, int, int, uint64_t&, WorkerStats*,
+                              const function<void(size_t)>&);
+    static const TailSolve table[] = {solveTailFor<1>, solveTailFor<2>, solveTailFor<3>, solveTailFor<4>,
+                                      solveTailFor<5>, solveTailFor<6>, solveTailFor<7>};
+    static_assert(sizeof(table) / sizeof(table[0]) == MAX_TAIL_LENGTH, "one solve per tail length");
+    return table[index.tailLength - 1](index, state, iter, limit, tail, stats, fillRow);
+}
+
+
+SharedIncumbent::SharedIncumbent(int workers, uint64_t kmer, int distance, int floor)
+    : bestDistance(distance), lowerBound(floor), seedKmer(kmer), seedDistance(distance), slots(workers) {}
+
+
+void SharedIncumbent::offer(int worker, uint64_t kmer, int distance) {
+    Slot& slot = slots[worker];
+    if (!slot.found || distance < slot.distance) {
+        slot.kmer = kmer;
+        slot.distance = distance;
+        slot.found = true;
+    }
+    int current = bestDistance.load(memory_order_relaxed);
+    while (distance < current) {
+        if (bestDistance.compare_exchange_weak(current, distance, memory_order_relaxed)) {
+            STATS_ONLY(if (stats) stats->improvement(worker, kmer, distance);)
+            return;
+        }
+    }
+}
+
+
+int SharedIncumbent::best(uint64_t& kmer, int K) const {
+    kmer = seedKmer;
+    int distance = seedDistance;
+    string bestStr = decodeKmer(kmer, K);
+    for (const auto& slot : slots) {
+        if (!slot.found || slot.distance > distance) {
+            continue;
+        }
+        // offers are always strictly below the seed, so an equal distance here is another slot
+        string str = decodeKmer(slot.kmer, K);
+        if (slot.distance < distance || str < bestStr) {
+            kmer = slot.kmer;
+            distance = slot.distance;
+            bestStr = str;
+        }
+    }
+    return distance;
+}
+
+
+void branch_and_bound(const WindowIndex& index, PrefixState& state, uint64_t& currentKmer,
+                      SharedIncumbent& incumbent, const BoundSet* bounds, int worker, int iter, int currentDistance) {
+
+    STATS_ONLY(WorkerStats& stats = incumbent.stats->worker(worker);)
+    STATS_ONLY(stats.nodes[iter]++;)
+    WorkerStats* counters = nullptr;
+    STATS_ONLY(counters = &stats;)
+
+    int bound = incumbent.bound();
+    if (currentDistance >= bound || bound <= incumbent.floor()) {
+        STATS_ONLY(stats.pruned[iter]++;)
+        return;
+    }
+
+    if (bounds && iter < index.K) {
+        if (bounds->evaluate(index, state, iter, currentDistance, bound, counters) >= bound) {
+            STATS_ONLY(stats.pruned[iter]++;)
+            return;
+        }
+    }
+
+    // reached leaf node
+    if (iter == index.K) {
+        incumbent.offer(worker, currentKmer, currentDistance);
+        return;
+    }
+
+    // close enough to the leaves to finish the whole subtree at once
+    if (iter == index.K - index.tailLength) {
+        uint64_t tail = 0;
+        int distance = solveTail(index, state, iter, bound, tail, counters);
+        if (distance < bound) {
+            uint64_t kmer = (currentKmer & kmerMask(iter)) | (tail << (2 * iter));
+            incumbent.offer(worker, kmer, distance);
+        }
+        return;
+    }
+
+    const ChildOrder& childOrder = state.childOrder;
+    int order[4] = {childOrder.codes[0], childOrder.codes[1], childOrder.codes[2], childOrder.codes[3]};
+    int distances[4];
+    // leaf children are scored exactly by the sibling pass, so they need no row of their own
+    bool leaves = iter + 1 == index.K;
+    bool scored = childOrder.bestChildFirst || leaves;
+    if (scored) {
+        scoreChildren(index, state, iter, distances, bound, counters);
+    }
+    if (childOrder.bestChildFirst) {
+        // insertion sort keeps the static order among equal distances
+        for (int i = 1; i < 4; ++i) {
+            for (int j = i; j > 0 && distances[order[j]] < distances[order[j - 1]]; --j) {
+                swap(order[j], order[j - 1]);
+            }
+        }
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        int code = order[i];
+        // already scored children the bound rules out need no row of their own; sorted ones
+        // take their later siblings with them
+        if (scored && distances[code] >= incumbent.bound()) {
+            if (!childOrder.bestChildFirst) {
+                STATS_ONLY(stats.nodes[iter + 1]++;)
+                STATS_ONLY(stats.pruned[iter + 1]++;)
+                continue;
+            }
+            STATS_ONLY(stats.nodes[iter + 1] += 4 - i;)
+            STATS_ONLY(stats.pruned[iter + 1] += 4 - i;)
+            break;
+        }
+        currentKmer = (currentKmer & ~(3ULL << (2 * iter))) | (static_cast<uint64_t>(code) << (2 * iter));
+        if (leaves) {
+            STATS_ONLY(stats.nodes[iter + 1]++;)
+            incumbent.offer(worker, currentKmer, distances[code]);
+            continue;
+        }
+        // a child the bound rules out is dropped by its own call, before its row is read
+        int childDistance = extendPrefix(index, state, iter, code, incumbent.bound(), counters);
+        branch_and_bound(index, state, currentKmer, incumbent, bounds, worker, iter + 1, childDistance);
+    }
+
+}
+
+
+void branch_and_bound(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, int floor,
+                      const BoundSet* bounds) {
+    PrefixState state = makePrefixState(index);
+    SharedIncumbent incumbent(1, bestKmer, bestDistance, floor);
+    STATS_ONLY(SearchStats stats("bnb", index.K, 1);)
+    STATS_ONLY(if (bounds) stats.setBounds(bounds->names());)
+    STATS_ONLY(incumbent.stats = &stats;)
+    uint64_t currentKmer = 0;
+    branch_and_bound(index, state, currentKmer, incumbent, bounds, 0, 0, 0);
+    bestDistance = incumbent.best(bestKmer, index.K);
+    STATS_ONLY(stats.finish(bestDistance);)
+}
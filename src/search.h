@@ -0,0 +1,240 @@
+#ifndef MEDIAN_STRING_SEARCH_H
+#define MEDIAN_STRING_SEARCH_H
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "packed_sequence.h"
+#include "kmer_summary.h"
+#include "search_stats.h"
+
+class BoundSet;
+
+// windows of one sequence whose last tailLength codes include non-ACGT positions, grouped
+// by what those codes are
+struct InvalidTail {
+    uint16_t kmer;      // ACGT positions packed, the others read as A
+    uint16_t invalid;   // 0b01 at each non-ACGT position
+    std::vector<uint32_t> windows;
+};
+
+// order branch_and_bound visits the children of a node in. with bestChildFirst, ascending
+// child distance first and codes among equal distances
+struct ChildOrder {
+    bool bestChildFirst = false;
+    uint8_t codes[4] = {0, 1, 2, 3};
+};
+
+// read-only view of the inputs shared by every search over one K. windows are the K-length
+// windows of each sequence; a prefix of length iter is scored against their first iter
+// positions, which is still a lower bound on the final distance and never looser than
+// scoring it against all iter-length windows
+struct WindowIndex {
+    int K = 0;
+    std::vector<std::vector<uint8_t>> codes;  // nucleotide codes per sequence, see plane()
+    std::vector<size_t> strides;              // distance between consecutive planes of codes[s]
+    std::vector<size_t> windows;              // K-length windows per sequence
+    std::vector<size_t> offsets;              // first window of each sequence within a depth row
+    size_t totalWindows = 0;
+
+    // tables for finishing a prefix of length K - tailLength in one step, see prepareTailSolve.
+    // tailCodes holds the last tailLength codes of every window packed into a word, or
+    // INVALID_TAIL when one of them is not ACGT; those windows are in invalidTails instead
+    int tailLength = 0;
+    std::vector<uint16_t> tailCodes;
+    std::vector<std::vector<InvalidTail>> invalidTails;
+    std::vector<uint16_t> tailLexOrder;   // every packed tail, lexicographically sorted
+
+    // configured child order, see prepareChildOrder; every PrefixState starts with it
+    ChildOrder childOrder;
+    // whether prefix states learn the order they scan sequences in, see SequenceOrder
+    bool adaptiveOrder = true;
+
+    // code at position j of every window of sequence s, window w at index w. for a whole
+    // sequence this is just the sequence shifted by j (stride 1); summaries store one
+    // plane per position
+    const uint8_t* plane(size_t s, int j) const { return codes[s].data() + j * strides[s]; }
+};
+
+WindowIndex buildWindowIndex(const std::vector<PackedSequence>& sequences, int K);
+
+// windows are the distinct k-mers of each summary, so the raw sequences are not needed
+WindowIndex buildWindowIndex(const std::vector<KmerSummary>& summaries);
+
+// add one summary as the next sequence of index; lets streamed records be dropped as soon
+// as they are indexed. index.K must be zero or match summary.K. drops any tail tables
+void appendToWindowIndex(WindowIndex& index, const KmerSummary& summary);
+
+// index of length L over the last L positions of every window of index, window for window.
+// 1 <= L <= index.K
+WindowIndex suffixWindowIndex(const WindowIndex& index, int L);
+
+// distance of a packed index.K-mer against the windows of index
+int indexDistance(const WindowIndex& index, uint64_t kmer);
+
+const int MAX_TAIL_LENGTH = 7;
+const uint16_t INVALID_TAIL = 0xFFFF;
+
+// the last L levels of the search tree solved in one step per node: below a prefix, window w
+// costs its prefix mismatches a_w plus its Hamming distance to the tail, so each sequence's
+// contribution for every tail at once is a distance transform of the a_w over 4^L cells.
+// that is exact, so the subtree needs no expanding. length < 0 picks L from the input size;
+// 0 turns it off
+void prepareTailSolve(WindowIndex& index, int length = -1);
+
+// child orders: "fixed" is A, C, G, T; "frequency" puts the nucleotides most common in the
+// windows first; "best" scores all four children first and descends into the closest one
+// first, so good incumbents turn up early, ties in A, C, G, T order. throws
+// invalid_argument on any other name
+bool isChildOrder(const std::string& order);
+void prepareChildOrder(WindowIndex& index, const std::string& order);
+
+
+// scans between two re-sorts of a SequenceOrder
+const uint32_t SEQUENCE_REORDER_INTERVAL = 1024;
+
+// order the scans from one depth visit the sequences in. they stop as soon as a prefix is
+// ruled out, so the sequences adding the most distance per window scanned should come first.
+// gains[s] sums the minimum sequence s added over the scans that reached it and samples[s]
+// counts those scans; every SEQUENCE_REORDER_INTERVAL scans the order is re-sorted by
+// gains / samples / windows and both are halved, so the order follows the search around.
+// it starts shortest sequence first, or in input order with adaptiveOrder off
+struct SequenceOrder {
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> gains;
+    std::vector<uint32_t> samples;
+    uint32_t scans = 0;
+};
+
+// a sequence's row turns sparse once at most one in COMPACT_RATIO of its windows is active
+const size_t COMPACT_RATIO = 16;
+// activeSizes entry of a row that still holds every window
+const uint32_t DENSE_ROW = UINT32_MAX;
+
+// per-window mismatch counts for every depth of the current path. row d holds the
+// mismatches of each window against the first d prefix positions, so extending the
+// prefix by one nucleotide is a single compare per window.
+// a window whose count reaches its sequence's minimum plus the positions still open can
+// never be that sequence's best below the path, so extendPrefix drops it. once few windows
+// of a sequence remain active its row is compacted: their counts are packed at the start of
+// the sequence's slice of the row and their window numbers listed in activeIds, and deeper
+// rows only ever shrink that list. see activeWindows
+struct PrefixState {
+    std::vector<std::vector<uint8_t>> depthCounts;
+    std::vector<std::vector<uint8_t>> minima;          // per depth and sequence
+    std::vector<std::vector<uint32_t>> activeSizes;    // per depth and sequence, or DENSE_ROW
+    std::vector<std::vector<uint32_t>> activeIds;      // per depth, sequence s from activeOffsets[s]
+    std::vector<size_t> activeOffsets;
+    ChildOrder childOrder;   // of the search using this state; the index's unless changed
+    std::vector<SequenceOrder> sequenceOrders;   // per depth, for the scans reading that row
+    // scratch for solveTail
+    std::vector<uint8_t> tailTable;
+    std::vector<uint32_t> tailTotals;
+};
+
+PrefixState makePrefixState(const WindowIndex& index);
+
+// the windows of sequence s still active in row iter: their counts, and their window numbers
+// unless the row is dense, in which case ids is null and window w is at counts[w]
+struct ActiveWindows {
+    const uint8_t* counts;
+    const uint32_t* ids;
+    size_t size;
+};
+
+inline ActiveWindows activeWindows(const WindowIndex& index, const PrefixState& state, int iter, size_t s) {
+    const uint8_t* counts = state.depthCounts[iter].data() + index.offsets[s];
+    uint32_t size = state.activeSizes[iter][s];
+    if (size == DENSE_ROW) {
+        return {counts, nullptr, index.windows[s]};
+    }
+    return {counts, state.activeIds[iter].data() + state.activeOffsets[s], size};
+}
+
+// windows scanned between checks for an early exit, so the scans stay vectorized
+const size_t EXIT_CHECK_WINDOWS = 256;
+
+// fill row iter+1 from row iter with code placed at prefix position iter.
+// returns the summed per-sequence minimum, i.e. the distance of the extended prefix.
+// once that sum reaches limit the prefix is ruled out: the scan stops there and returns a
+// value >= limit, leaving row iter+1 unfinished. stats, if given, counts the windows scanned
+int extendPrefix(const WindowIndex& index, PrefixState& state, int iter, int code, int limit = INT_MAX,
+                 WorkerStats* stats = nullptr);
+
+// distance of each of the four one-nucleotide extensions of the prefix in row iter, in a
+// single pass that writes no row. a sequence is left as soon as all four of its minima are
+// 0, and the pass stops once every distance reaches limit; those are then >= limit
+void scoreChildren(const WindowIndex& index, PrefixState& state, int iter, int distances[4],
+                   int limit = INT_MAX, WorkerStats* stats = nullptr);
+
+// best completion of the prefix held in row iter = K - tailLength of state. returns its
+// distance and the packed tail; ties go to the lexicographically smallest tail. returns
+// limit, leaving tail untouched, as soon as no completion can go below limit. stats, if
+// given, counts the windows scanned. fillRow, if given, is called with each sequence before
+// its part of row iter is read, so a caller can build the row lazily
+int solveTail(const WindowIndex& index, PrefixState& state, int iter, int limit, uint64_t& tail,
+              WorkerStats* stats = nullptr, const std::function<void(size_t)>& fillRow = nullptr);
+
+
+// best k-mer found so far, shared by every worker of a search. the bound is a single atomic
+// lowered with compare-and-swap; each worker writes its own improvements to a private slot,
+// so publishing never takes a lock and the winning k-mer is read back once workers joined
+class SharedIncumbent {
+public:
+    SharedIncumbent(int workers, uint64_t kmer, int distance, int floor = 0);
+
+    int bound() const { return bestDistance.load(std::memory_order_relaxed); }
+
+    // a known lower bound on the optimum; once the incumbent reaches it the search is over
+    int floor() const { return lowerBound.load(std::memory_order_relaxed); }
+    bool proven() const { return bound() <= floor(); }
+
+    // a search that has covered the whole tree knows the incumbent is optimal; raising the
+    // floor to it makes every other search over the same tree stop at its next node
+    void prove() { lowerBound.store(bound(), std::memory_order_relaxed); }
+
+    // record an improvement found by worker and lower the shared bound if it is still better.
+    // only an offer that lowers the bound is reported to stats
+    void offer(int worker, uint64_t kmer, int distance);
+
+    // best k-mer across all workers; only valid once they have finished. ties go to the
+    // starting k-mer, then to the lexicographically smallest
+    int best(uint64_t& kmer, int K) const;
+
+#ifdef MEDIAN_STATS
+    SearchStats* stats = nullptr;   // counters of the search this incumbent belongs to
+#endif
+
+private:
+    struct alignas(64) Slot {
+        uint64_t kmer = 0;
+        int distance = 0;
+        bool found = false;
+    };
+
+    std::atomic<int> bestDistance;
+    std::atomic<int> lowerBound;
+    uint64_t seedKmer;
+    int seedDistance;
+    std::vector<Slot> slots;
+};
+
+
+// depth-first search below the prefix held in state at depth iter, pruning against the
+// shared incumbent. currentDistance is the distance of that prefix. bounds, if not null,
+// are consulted at every inner node the prefix distance alone does not prune
+void branch_and_bound(const WindowIndex& index, PrefixState& state, uint64_t& currentKmer,
+                      SharedIncumbent& incumbent, const BoundSet* bounds, int worker, int iter, int currentDistance);
+
+// full search from the empty prefix. bestKmer/bestDistance carry the starting incumbent in
+// and the optimum out. floor is a known lower bound on the optimum (0 if none): the search
+// stops as soon as it is reached
+void branch_and_bound(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance, int floor = 0,
+                      const BoundSet* bounds = nullptr);
+
+#endif
@@ -0,0 +1,223 @@
+#include "search_stats.h"
+
+#include <atomic>
+
+#include "packed_sequence.h"
+
+using namespace std;
+
+
+namespace {
+
+struct BoundRecord {
+    string name;
+    uint64_t evaluations;
+    uint64_t prunes;
+    double seconds;
+};
+
+struct SearchRecord {
+    string phase;
+    string engine;
+    int K;
+    int workers;
+    double seconds;
+    int bestDistance;
+    vector<uint64_t> nodes;
+    vector<uint64_t> pruned;
+    uint64_t windows;
+    vector<Improvement> improvements;
+    vector<BoundRecord> bounds;
+};
+
+struct PhaseRecord {
+    string name;
+    double seconds;
+};
+
+// the run report. searches may finish on several threads at once
+struct Report {
+    mutex lock;
+    chrono::steady_clock::time_point phaseStart;
+    string phase;
+    vector<PhaseRecord> phases;
+    vector<SearchRecord> searches;
+    atomic<uint64_t> otherWindows{0};
+};
+
+Report& report() {
+    static Report r;
+    return r;
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void writeArray(ostream& out, const vector<uint64_t>& values) {
+    out << '[';
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i ? "," : "") << values[i];
+    }
+    out << ']';
+}
+
+// names come from file paths, so quotes and backslashes have to be escaped
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (static_cast<unsigned char>(c) < 0x20) {
+            // control characters are only valid escaped
+            const char* hex = "0123456789abcdef";
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 15];
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+}
+
+
+SearchStats::SearchStats(const string& engine, int K, int workers)
+    : engine(engine), K(K), start(chrono::steady_clock::now()), workers(workers) {
+    for (auto& w : this->workers) {
+        w.nodes.assign(K + 1, 0);
+        w.pruned.assign(K + 1, 0);
+    }
+}
+
+
+void SearchStats::setBounds(const vector<string>& names) {
+    boundNames = names;
+    for (auto& w : workers) {
+        w.boundEvaluations.assign(names.size(), 0);
+        w.boundPrunes.assign(names.size(), 0);
+        w.boundNanos.assign(names.size(), 0);
+    }
+}
+
+
+void SearchStats::improvement(int worker, uint64_t kmer, int distance) {
+    double seconds = secondsSince(start);
+    lock_guard<mutex> lock(improvementsLock);
+    improvements.push_back({seconds, worker, kmer, distance});
+}
+
+
+void SearchStats::finish(int bestDistance) {
+    SearchRecord record;
+    record.engine = engine;
+    record.K = K;
+    record.workers = static_cast<int>(workers.size());
+    record.seconds = secondsSince(start);
+    record.bestDistance = bestDistance;
+    record.nodes.assign(K + 1, 0);
+    record.pruned.assign(K + 1, 0);
+    record.windows = 0;
+    for (const auto& w : workers) {
+        for (int d = 0; d <= K; ++d) {
+            record.nodes[d] += w.nodes[d];
+            record.pruned[d] += w.pruned[d];
+        }
+        record.windows += w.windows;
+    }
+    for (size_t b = 0; b < boundNames.size(); ++b) {
+        BoundRecord bound = {boundNames[b], 0, 0, 0};
+        for (const auto& w : workers) {
+            bound.evaluations += w.boundEvaluations[b];
+            bound.prunes += w.boundPrunes[b];
+            bound.seconds += w.boundNanos[b] * 1e-9;
+        }
+        record.bounds.push_back(bound);
+    }
+    {
+        lock_guard<mutex> lock(improvementsLock);
+        record.improvements = improvements;
+    }
+
+    Report& r = report();
+    lock_guard<mutex> lock(r.lock);
+    record.phase = r.phase;
+    r.searches.push_back(move(record));
+}
+
+
+void statsStartPhase(const string& name) {
+    statsStopPhase();
+    Report& r = report();
+    lock_guard<mutex> lock(r.lock);
+    r.phase = name;
+    r.phaseStart = chrono::steady_clock::now();
+}
+
+
+void statsStopPhase() {
+    Report& r = report();
+    lock_guard<mutex> lock(r.lock);
+    if (!r.phase.empty()) {
+        r.phases.push_back({r.phase, secondsSince(r.phaseStart)});
+        r.phase.clear();
+    }
+}
+
+
+void statsAddWindows(uint64_t windows) {
+    report().otherWindows.fetch_add(windows, memory_order_relaxed);
+}
+
+
+void statsLastSearch(uint64_t& nodes, uint64_t& windows) {
+    Report& r = report();
+    lock_guard<mutex> lock(r.lock);
+    nodes = 0;
+    windows = 0;
+    if (r.searches.empty()) {
+        return;
+    }
+    for (uint64_t count : r.searches.back().nodes) {
+        nodes += count;
+    }
+    windows = r.searches.back().windows;
+}
+
+
+void writeStatsJson(ostream& out) {
+    Report& r = report();
+    lock_guard<mutex> lock(r.lock);
+    out << "{\n  \"phases\": [";
+    for (size_t i = 0; i < r.phases.size(); ++i) {
+        out << (i ? "," : "") << "\n    {\"name\": " << jsonString(r.phases[i].name)
+            << ", \"seconds\": " << r.phases[i].seconds << "}";
+    }
+    out << "\n  ],\n  \"searches\": [";
+    for (size_t i = 0; i < r.searches.size(); ++i) {
+        const SearchRecord& s = r.searches[i];
+        out << (i ? "," : "") << "\n    {\"phase\": " << jsonString(s.phase) << ", \"engine\": " << jsonString(s.engine)
+            << ", \"K\": " << s.K << ", \"workers\": " << s.workers << ", \"seconds\": " << s.seconds
+            << ", \"best_distance\": " << s.bestDistance << ",\n     \"nodes_per_depth\": ";
+        writeArray(out, s.nodes);
+        out << ",\n     \"pruned_per_depth\": ";
+        writeArray(out, s.pruned);
+        out << ",\n     \"windows_scanned\": " << s.windows << ",\n     \"improvements\": [";
+        for (size_t j = 0; j < s.improvements.size(); ++j) {
+            const Improvement& imp = s.improvements[j];
+            out << (j ? ", " : "") << "{\"seconds\": " << imp.seconds << ", \"worker\": " << imp.worker
+                << ", \"kmer\": \"" << decodeKmer(imp.kmer, s.K) << "\", \"distance\": " << imp.distance << "}";
+        }
+        out << "],\n     \"bounds\": [";
+        for (size_t j = 0; j < s.bounds.size(); ++j) {
+            const BoundRecord& b = s.bounds[j];
+            out << (j ? ", " : "") << "{\"name\": " << jsonString(b.name) << ", \"evaluations\": " << b.evaluations
+                << ", \"prunes\": " << b.prunes << ", \"seconds\": " << b.seconds << "}";
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n  \"other_windows_scanned\": " << r.otherWindows.load() << "\n}" << endl;
+}
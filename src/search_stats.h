@@ -0,0 +1,80 @@
+#ifndef MEDIAN_STRING_SEARCH_STATS_H
+#define MEDIAN_STRING_SEARCH_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// search instrumentation, built only with -DMEDIAN_STATS=ON. every hook in the search code
+// is wrapped in STATS_ONLY, so a normal build carries no counters and no extra branches
+#ifdef MEDIAN_STATS
+#define STATS_ONLY(...) __VA_ARGS__
+#else
+#define STATS_ONLY(...)
+#endif
+
+
+// counters owned by one worker; padded so workers never share a cache line
+struct alignas(64) WorkerStats {
+    std::vector<uint64_t> nodes;    // nodes entered per depth, root at 0
+    std::vector<uint64_t> pruned;   // nodes cut by the bound per depth
+    uint64_t windows = 0;           // window comparisons done for this search
+    // per lower bound of the search's BoundSet, in its order
+    std::vector<uint64_t> boundEvaluations;
+    std::vector<uint64_t> boundPrunes;
+    std::vector<uint64_t> boundNanos;
+};
+
+struct Improvement {
+    double seconds;   // since the search started
+    int worker;
+    uint64_t kmer;
+    int distance;
+};
+
+
+// counters of one search run. workers bump their own WorkerStats without locking; the rare
+// incumbent improvements take a lock
+class SearchStats {
+public:
+    SearchStats(const std::string& engine, int K, int workers);
+
+    WorkerStats& worker(int id) { return workers[id]; }
+
+    // name the lower bounds the search consults; call before the workers start
+    void setBounds(const std::vector<std::string>& names);
+
+    void improvement(int worker, uint64_t kmer, int distance);
+
+    // merge the workers and add the search to the run report, tagged with the current phase
+    void finish(int bestDistance);
+
+private:
+    std::string engine;
+    int K;
+    std::chrono::steady_clock::time_point start;
+    std::vector<WorkerStats> workers;
+    std::vector<std::string> boundNames;
+    std::mutex improvementsLock;
+    std::vector<Improvement> improvements;
+};
+
+
+// phases are sequential; starting one stops the previous
+void statsStartPhase(const std::string& name);
+void statsStopPhase();
+
+// windows compared outside a search, e.g. by distanceTotal
+void statsAddWindows(uint64_t windows);
+
+// nodes entered and windows compared by the search that finished last, both 0 before any
+void statsLastSearch(uint64_t& nodes, uint64_t& windows);
+
+// everything recorded so far as one JSON object
+void writeStatsJson(std::ostream& out);
+
+#endif
@@ -0,0 +1,92 @@
+#include "solver.h"
+
+#include <climits>
+
+#include "parallel_search.h"
+#include "best_first_search.h"
+#include "portfolio_search.h"
+#include "exhaustive_search.h"
+#include "hypercube_search.h"
+#include "bitslice_search.h"
+#include "lower_bound.h"
+#include "local_search.h"
+
+using namespace std;
+
+
+string resolveEngine(const string& engine, int K, size_t sequences) {
+    bool hypercubeFits = K <= MAX_HYPERCUBE_K && sequences * K <= UINT16_MAX;
+    if (engine == "auto") {
+        return K <= AUTO_EXHAUSTIVE_K && hypercubeFits ? "hypercube" : "bnb";
+    }
+    if ((engine == "hypercube" && !hypercubeFits) || (engine == "gray" && K > MAX_GRAY_K)) {
+        return "bnb";
+    }
+    return engine;
+}
+
+
+void runSearch(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance,
+               const SearchSettings& settings, const BoundSet* bounds, int floor) {
+    if (settings.engine == "bestfirst") {
+        best_first_search(index, bestKmer, bestDistance, static_cast<size_t>(settings.queueMegabytes) << 20, floor,
+                          bounds);
+        return;
+    }
+    if (settings.engine == "bitslice") {
+        bitslice_search(index, bestKmer, bestDistance, floor);
+        return;
+    }
+    if (settings.engine == "portfolio") {
+        portfolio_search(index, bestKmer, bestDistance, max(settings.threads, 2), floor, bounds);
+        return;
+    }
+    if (settings.threads <= 1) {
+        branch_and_bound(index, bestKmer, bestDistance, floor, bounds);
+        return;
+    }
+    int splitDepth = settings.splitDepth > 0 ? settings.splitDepth : defaultSplitDepth(maxSplitDepth(index), settings.threads);
+    parallel_branch_and_bound(index, bestKmer, bestDistance, settings.threads, splitDepth, floor, bounds);
+}
+
+
+void prepareSearchIndex(WindowIndex& index, const SearchSettings& settings) {
+    prepareTailSolve(index, settings.tailLength);
+    prepareChildOrder(index, settings.order);
+    index.adaptiveOrder = settings.adaptiveOrder;
+}
+
+
+WindowIndex buildSearchIndex(const vector<PackedSequence>& sequences, int K, const SearchSettings& settings) {
+    WindowIndex index = buildWindowIndex(sequences, K);
+    prepareSearchIndex(index, settings);
+    return index;
+}
+
+
+int polishSeed(const WindowIndex& index, uint64_t& kmer, int distance, const SearchSettings& settings) {
+    if (!settings.polish) {
+        return distance;
+    }
+    return polishKmer(index, kmer, settings.restarts);
+}
+
+
+void solveMedian(const vector<PackedSequence>& sequences, int K, const SearchSettings& settings,
+                 uint64_t& bestKmer, int& bestDistance, int floor) {
+    string engine = resolveEngine(settings.engine, K, sequences.size());
+    if (engine == "hypercube") {
+        hypercube_search(sequences, bestKmer, bestDistance, K);
+        return;
+    }
+    if (engine == "gray") {
+        gray_code_search(buildWindowIndex(sequences, K), bestKmer, bestDistance);
+        return;
+    }
+    WindowIndex index = buildSearchIndex(sequences, K, settings);
+    if (bestDistance != INT_MAX) {
+        bestDistance = polishSeed(index, bestKmer, bestDistance, settings);
+    }
+    unique_ptr<BoundSet> bounds = makeBoundSet(settings.bounds, index);
+    runSearch(index, bestKmer, bestDistance, settings, bounds.get(), floor);
+}
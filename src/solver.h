@@ -0,0 +1,60 @@
+#ifndef MEDIAN_STRING_SOLVER_H
+#define MEDIAN_STRING_SOLVER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packed_sequence.h"
+#include "search.h"
+#include "best_first_search.h"
+
+
+// which engine runs a search and how it is spread over threads
+struct SearchSettings {
+    std::string engine = "bnb";      // bnb, bestfirst, portfolio, bitslice, gray, hypercube or auto
+    int threads = 1;
+    int splitDepth = 0;   // 0: pick from K and the thread count
+    std::string bounds = "prefix";   // lower bounds for branch and bound, see parseBoundSpec
+    int tailLength = -1;             // levels finished by solveTail; -1 picks, 0 disables
+    std::string order = "best";      // child visiting order, see prepareChildOrder
+    int queueMegabytes = DEFAULT_QUEUE_MB;   // open list ceiling of the bestfirst engine
+    bool polish = true;              // improve a starting k-mer by local search first
+    int restarts = 4;                // random restarts of that local search, see polishKmer
+    bool adaptiveOrder = true;       // learn which sequences to scan first, see SequenceOrder
+};
+
+// largest K the auto engine solves with the hypercube engine; its 4^K tables beat any
+// pruning up to about here, above it branch and bound is the only engine that scales
+const int AUTO_EXHAUSTIVE_K = 11;
+
+// the engine that runs a search over sequences sequences at length K (0 if not known yet).
+// "auto" is the hypercube engine up to AUTO_EXHAUSTIVE_K and bnb above. the exhaustive
+// engines become bnb past the K or sequence count their tables hold
+std::string resolveEngine(const std::string& engine, int K, size_t sequences);
+
+// run branch and bound over index with bounds, the configured lower bounds built for it by
+// makeBoundSet (null for none): best-first for the
+// bestfirst engine, one member per thread (at least two) for the portfolio engine, over bit
+// slices for the bitslice engine, which takes no bounds and runs on one thread, otherwise
+// depth-first, where a single thread keeps the plain recursion. floor as for branch_and_bound
+void runSearch(const WindowIndex& index, uint64_t& bestKmer, int& bestDistance,
+               const SearchSettings& settings, const BoundSet* bounds, int floor = 0);
+
+// set up the configured tail tables, child and sequence order of an index for branch and bound
+void prepareSearchIndex(WindowIndex& index, const SearchSettings& settings);
+
+// index for a branch and bound run: whole sequences, prepared as above
+WindowIndex buildSearchIndex(const std::vector<PackedSequence>& sequences, int K, const SearchSettings& settings);
+
+// local search from a starting k-mer when settings ask for it; returns its new distance
+int polishSeed(const WindowIndex& index, uint64_t& kmer, int distance, const SearchSettings& settings);
+
+// median of sequences at length K with the engine resolveEngine picks. bestKmer/bestDistance carry a
+// starting incumbent in and the optimum out; the branch and bound engines polish it first.
+// floor is a known lower bound on the optimum (0 if none). the hypercube engine ignores
+// both, it scores every k-mer anyway
+void solveMedian(const std::vector<PackedSequence>& sequences, int K, const SearchSettings& settings,
+                 uint64_t& bestKmer, int& bestDistance, int floor = 0);
+
+#endif
@@ -0,0 +1,298 @@
+#include "window_kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MEDIAN_X86_KERNELS 1
+#endif
+
+using namespace std;
+
+
+namespace {
+
+// windows scored per block by the vector kernels; one AVX-512 register, two AVX2, four SSE
+const size_t BLOCK = 64;
+const int MAX_L = 32;
+
+// packed byte -> its four 2-bit codes, one per byte
+struct UnpackTable {
+    uint8_t codes[256][4];
+    UnpackTable() {
+        for (int b = 0; b < 256; ++b) {
+            for (int k = 0; k < 4; ++k) {
+                codes[b][k] = (b >> (2 * k)) & 3;
+            }
+        }
+    }
+};
+const UnpackTable unpackTable;
+
+inline uint8_t packedByte(const vector<uint64_t>& plane, size_t k) {
+    return static_cast<uint8_t>(plane[k >> 3] >> ((k & 7) * 8));
+}
+
+// expand nucleotides [start, start + count) to one byte each. invalid positions become 4..7
+// so they never equal a k-mer code. returns the address of position start inside buf, which
+// must hold count + 8 bytes. forced inline: the per-length kernels are too many for the
+// inliner's budget, and a call per block costs about as much as scoring the block
+__attribute__((always_inline)) inline const uint8_t* unpackCodes(const PackedSequence& seq, size_t start, size_t count, uint8_t* buf) {
+    size_t first = start >> 2;
+    size_t last = (start + count + 3) >> 2;
+    uint8_t* out = buf;
+    for (size_t k = first; k < last; ++k, out += 4) {
+        const uint8_t* c = unpackTable.codes[packedByte(seq.bits, k)];
+        out[0] = c[0]; out[1] = c[1]; out[2] = c[2]; out[3] = c[3];
+    }
+    if (seq.hasInvalid) {
+        out = buf;
+        for (size_t k = first; k < last; ++k, out += 4) {
+            const uint8_t* c = unpackTable.codes[packedByte(seq.invalid, k)];
+            out[0] |= c[0] << 2; out[1] |= c[1] << 2; out[2] |= c[2] << 2; out[3] |= c[3] << 2;
+        }
+    }
+    return buf + (start & 3);
+}
+
+// popcount scan over windows [begin, end). shared by every kernel for the ragged tail
+template <int L>
+inline int scanRange(uint64_t kmer, const PackedSequence& seq, size_t begin, size_t end, int minDist) {
+    for (size_t i = begin; i < end; ++i) {
+        uint64_t x = kmer ^ packedWindow(seq.bits, i, L);
+        uint64_t mismatches = (x | (x >> 1)) & EVEN_BITS;
+        if (seq.hasInvalid) {
+            mismatches |= packedWindow(seq.invalid, i, L);
+        }
+        int dist = __builtin_popcountll(mismatches);
+        if (dist < minDist) {
+            minDist = dist;
+            // an exact match: no window can do better
+            if (minDist == 0) {
+                break;
+            }
+        }
+    }
+    return minDist;
+}
+
+inline size_t windowCount(int L, const PackedSequence& seq) {
+    return seq.length >= static_cast<size_t>(L) ? seq.length - L + 1 : 0;
+}
+
+
+// every kernel is instantiated once per k-mer length: with L a constant the position loops
+// unroll completely, the broadcast k-mer codes live in registers and the window masks fold
+// to immediates. scanByLength picks the instantiation at runtime
+typedef int (*FixedScanFn)(uint64_t kmer, const PackedSequence& seq);
+
+template <template <int> class Kernel, size_t... L>
+array<FixedScanFn, MAX_L + 1> lengthTable(index_sequence<L...>) {
+    return {{&Kernel<L>::scan...}};
+}
+
+template <template <int> class Kernel>
+int scanByLength(uint64_t kmer, int L, const PackedSequence& seq) {
+    static const array<FixedScanFn, MAX_L + 1> table = lengthTable<Kernel>(make_index_sequence<MAX_L + 1>());
+    return table[L](kmer, seq);
+}
+
+
+template <int L>
+struct ScalarScan {
+    static int scan(uint64_t kmer, const PackedSequence& seq) {
+        return scanRange<L>(kmer, seq, 0, windowCount(L, seq), numeric_limits<int>::max());
+    }
+};
+
+
+#ifdef MEDIAN_X86_KERNELS
+
+// the vector kernels count mismatches vertically: lane w of the accumulator holds window i+w,
+// and step j compares the codes at i+w+j against k-mer position j for every lane at once.
+// each lane starts at L and drops by one per match, so no lane can exceed 32. after every
+// block a lane at 0 ends the scan: it is an exact match and nothing can beat it
+
+template <int L>
+struct SSE42Scan {
+    __attribute__((target("sse4.2")))
+    static int scan(uint64_t kmer, const PackedSequence& seq) {
+        size_t windows = windowCount(L, seq);
+        if (L == 0 || windows < BLOCK) {
+            return scanRange<L>(kmer, seq, 0, windows, numeric_limits<int>::max());
+        }
+
+        __m128i kc[L > 0 ? L : 1];
+        for (int j = 0; j < L; ++j) {
+            kc[j] = _mm_set1_epi8(static_cast<char>((kmer >> (2 * j)) & 3));
+        }
+        const __m128i start = _mm_set1_epi8(static_cast<char>(L));
+        __m128i vmin = _mm_set1_epi8(static_cast<char>(0xFF));
+
+        alignas(64) uint8_t buf[BLOCK + MAX_L + 8];
+        size_t i = 0;
+        for (; i + BLOCK <= windows; i += BLOCK) {
+            const uint8_t* codes = unpackCodes(seq, i, BLOCK + L - 1, buf);
+            for (size_t h = 0; h < BLOCK; h += 16) {
+                __m128i acc = start;
+                for (int j = 0; j < L; ++j) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + h + j));
+                    acc = _mm_add_epi8(acc, _mm_cmpeq_epi8(v, kc[j]));
+                }
+                vmin = _mm_min_epu8(vmin, acc);
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(vmin, _mm_setzero_si128()))) {
+                return 0;
+            }
+        }
+
+        // horizontal min: widen to 16 bits and let minpos finish it
+        __m128i lo = _mm_unpacklo_epi8(vmin, _mm_setzero_si128());
+        __m128i hi = _mm_unpackhi_epi8(vmin, _mm_setzero_si128());
+        int minDist = _mm_extract_epi16(_mm_minpos_epu16(_mm_min_epu16(lo, hi)), 0);
+        return scanRange<L>(kmer, seq, i, windows, minDist);
+    }
+};
+
+
+template <int L>
+struct AVX2Scan {
+    __attribute__((target("avx2,popcnt")))
+    static int scan(uint64_t kmer, const PackedSequence& seq) {
+        size_t windows = windowCount(L, seq);
+        if (L == 0 || windows < BLOCK) {
+            return scanRange<L>(kmer, seq, 0, windows, numeric_limits<int>::max());
+        }
+
+        __m256i kc[L > 0 ? L : 1];
+        for (int j = 0; j < L; ++j) {
+            kc[j] = _mm256_set1_epi8(static_cast<char>((kmer >> (2 * j)) & 3));
+        }
+        const __m256i start = _mm256_set1_epi8(static_cast<char>(L));
+        __m256i vmin = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+        alignas(64) uint8_t buf[BLOCK + MAX_L + 8];
+        size_t i = 0;
+        for (; i + BLOCK <= windows; i += BLOCK) {
+            const uint8_t* codes = unpackCodes(seq, i, BLOCK + L - 1, buf);
+            __m256i acc0 = start;
+            __m256i acc1 = start;
+            for (int j = 0; j < L; ++j) {
+                __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + j));
+                __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + 32 + j));
+                acc0 = _mm256_add_epi8(acc0, _mm256_cmpeq_epi8(v0, kc[j]));
+                acc1 = _mm256_add_epi8(acc1, _mm256_cmpeq_epi8(v1, kc[j]));
+            }
+            vmin = _mm256_min_epu8(vmin, _mm256_min_epu8(acc0, acc1));
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(vmin, _mm256_setzero_si256()))) {
+                return 0;
+            }
+        }
+
+        __m128i m = _mm_min_epu8(_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1));
+        __m128i lo = _mm_unpacklo_epi8(m, _mm_setzero_si128());
+        __m128i hi = _mm_unpackhi_epi8(m, _mm_setzero_si128());
+        int minDist = _mm_extract_epi16(_mm_minpos_epu16(_mm_min_epu16(lo, hi)), 0);
+        return scanRange<L>(kmer, seq, i, windows, minDist);
+    }
+};
+
+
+template <int L>
+struct AVX512Scan {
+    __attribute__((target("avx512f,avx512bw,popcnt")))
+    static int scan(uint64_t kmer, const PackedSequence& seq) {
+        size_t windows = windowCount(L, seq);
+        if (L == 0 || windows < BLOCK) {
+            return scanRange<L>(kmer, seq, 0, windows, numeric_limits<int>::max());
+        }
+
+        __m512i kc[L > 0 ? L : 1];
+        for (int j = 0; j < L; ++j) {
+            kc[j] = _mm512_set1_epi8(static_cast<char>((kmer >> (2 * j)) & 3));
+        }
+        const __m512i start = _mm512_set1_epi8(static_cast<char>(L));
+        const __m512i one = _mm512_set1_epi8(1);
+        __m512i vmin = _mm512_set1_epi8(static_cast<char>(0xFF));
+
+        alignas(64) uint8_t buf[BLOCK + MAX_L + 8];
+        size_t i = 0;
+        for (; i + BLOCK <= windows; i += BLOCK) {
+            const uint8_t* codes = unpackCodes(seq, i, BLOCK + L - 1, buf);
+            __m512i acc = start;
+            for (int j = 0; j < L; ++j) {
+                __m512i v = _mm512_loadu_si512(codes + j);
+                acc = _mm512_mask_sub_epi8(acc, _mm512_cmpeq_epi8_mask(v, kc[j]), acc, one);
+            }
+            vmin = _mm512_min_epu8(vmin, acc);
+            if (_mm512_cmpeq_epi8_mask(vmin, _mm512_setzero_si512())) {
+                return 0;
+            }
+        }
+
+        __m256i m256 = _mm256_min_epu8(_mm512_castsi512_si256(vmin), _mm512_extracti64x4_epi64(vmin, 1));
+        __m128i m = _mm_min_epu8(_mm256_castsi256_si128(m256), _mm256_extracti128_si256(m256, 1));
+        __m128i lo = _mm_unpacklo_epi8(m, _mm_setzero_si128());
+        __m128i hi = _mm_unpackhi_epi8(m, _mm_setzero_si128());
+        int minDist = _mm_extract_epi16(_mm_minpos_epu16(_mm_min_epu16(lo, hi)), 0);
+        return scanRange<L>(kmer, seq, i, windows, minDist);
+    }
+};
+
+#endif
+
+
+vector<WindowKernel> detectKernels() {
+    vector<WindowKernel> kernels;
+#ifdef MEDIAN_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("popcnt")) {
+        kernels.push_back({"avx512", scanByLength<AVX512Scan>});
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        kernels.push_back({"avx2", scanByLength<AVX2Scan>});
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        kernels.push_back({"sse4.2", scanByLength<SSE42Scan>});
+    }
+#endif
+    kernels.push_back({"scalar", scanByLength<ScalarScan>});
+    return kernels;
+}
+
+const WindowKernel* active = nullptr;
+
+}
+
+
+const vector<WindowKernel>& availableWindowKernels() {
+    static const vector<WindowKernel> kernels = detectKernels();
+    return kernels;
+}
+
+
+const WindowKernel& activeWindowKernel() {
+    if (!active) {
+        active = &availableWindowKernels().front();
+    }
+    return *active;
+}
+
+
+bool selectWindowKernel(const string& name) {
+    for (const auto& kernel : availableWindowKernels()) {
+        if (name == kernel.name) {
+            active = &kernel;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+int scanWindows(uint64_t kmer, int L, const PackedSequence& seq) {
+    return activeWindowKernel().scan(kmer, L, seq);
+}
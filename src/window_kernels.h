@@ -0,0 +1,31 @@
+#ifndef MEDIAN_STRING_WINDOW_KERNELS_H
+#define MEDIAN_STRING_WINDOW_KERNELS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packed_sequence.h"
+
+
+// minimum Hamming distance between a packed L-length k-mer and every L-length window of seq.
+// every kernel is compiled once per L in 0..32 and dispatches on L through a table
+typedef int (*WindowScanFn)(uint64_t kmer, int L, const PackedSequence& seq);
+
+struct WindowKernel {
+    const char* name;
+    WindowScanFn scan;
+};
+
+// kernels this host can run, fastest first. "scalar" is always last
+const std::vector<WindowKernel>& availableWindowKernels();
+
+// kernel used by scanWindows; picked from the CPU features at startup
+const WindowKernel& activeWindowKernel();
+
+// force a kernel by name, returns false if it is unknown or unsupported here
+bool selectWindowKernel(const std::string& name);
+
+int scanWindows(uint64_t kmer, int L, const PackedSequence& seq);
+
+#endif
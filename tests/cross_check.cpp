@@ -0,0 +1,610 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "src/packed_sequence.h"
+#include "src/window_kernels.h"
+#include "src/median_string.h"
+#include "src/search.h"
+#include "src/exhaustive_search.h"
+#include "src/hypercube_search.h"
+#include "src/best_first_search.h"
+#include "src/parallel_search.h"
+#include "src/lower_bound.h"
+#include "src/solver.h"
+#include "src/search_stats.h"
+#include "src/kmer_summary.h"
+#include "src/batch.h"
+
+using namespace std;
+
+
+// cross-checks of the fast paths against brute force on small seeded random inputs: every
+// window kernel against a plain scan of the text, every engine and search setting against
+// gray_code_search, which scores all 4^K k-mers without pruning, the streamed k-mer
+// summaries against the sequences they replace, and batch runs seeded and floored by the
+// shorter median against single searches. prints each mismatch and exits 1 if there was any
+
+
+int failures = 0;
+
+void fail(const string& what) {
+    if (++failures <= 20) {
+        cerr << "FAIL: " << what << endl;
+    }
+}
+
+
+// contents in a fresh temporary file; the caller removes it
+string writeTempFile(const string& contents) {
+    char path[] = "/tmp/median_check_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        throw runtime_error("could not create a temporary file");
+    }
+    close(fd);
+    ofstream(path, ios::binary) << contents;
+    return path;
+}
+
+
+string randomSequence(mt19937& gen, size_t length, double invalid) {
+    uniform_real_distribution<double> coin(0, 1);
+    string seq(length, 'A');
+    for (auto& c : seq) {
+        c = coin(gen) < invalid ? 'N' : "ACGT"[gen() & 3];
+    }
+    return seq;
+}
+
+// minimum Hamming distance of kmer to the L-length windows of text; N never matches
+int bruteDistance(const string& kmer, const string& text) {
+    int best = INT_MAX;
+    for (size_t p = 0; p + kmer.size() <= text.size(); ++p) {
+        int d = 0;
+        for (size_t j = 0; j < kmer.size(); ++j) {
+            d += text[p + j] != kmer[j];
+        }
+        best = min(best, d);
+    }
+    return best;
+}
+
+int bruteTotal(const string& kmer, const vector<string>& texts) {
+    int total = 0;
+    for (const auto& text : texts) {
+        total += bruteDistance(kmer, text);
+    }
+    return total;
+}
+
+
+// every kernel at every L, for random k-mers, exact windows and windows one change away
+void checkKernels() {
+    mt19937 gen(20);
+    vector<string> texts;
+    for (size_t length : {1, 7, 31, 32, 33, 63, 64, 65, 100, 257, 1000, 4099}) {
+        texts.push_back(randomSequence(gen, length, 0));
+        texts.push_back(randomSequence(gen, length, 0.05));
+    }
+    string original = activeWindowKernel().name;
+    for (const auto& text : texts) {
+        PackedSequence seq = encodeSequence(text);
+        for (int L = 1; L <= MAX_KMER_LENGTH && static_cast<size_t>(L) <= text.size(); ++L) {
+            vector<string> kmers;
+            kmers.push_back(randomSequence(gen, L, 0));
+            string window = text.substr(gen() % (text.size() - L + 1), L);
+            replace(window.begin(), window.end(), 'N', 'G');
+            kmers.push_back(window);
+            window[gen() % L] = "ACGT"[gen() & 3];
+            kmers.push_back(window);
+            for (const auto& kmer : kmers) {
+                int expected = bruteDistance(kmer, text);
+                uint64_t packed = encodeKmer(kmer, L);
+                for (const auto& kernel : availableWindowKernels()) {
+                    int got = kernel.scan(packed, L, seq);
+                    if (got != expected) {
+                        fail(string("kernel ") + kernel.name + " L=" + to_string(L) + " length=" + to_string(text.size())
+                             + ": " + to_string(got) + " instead of " + to_string(expected));
+                    }
+                }
+            }
+        }
+    }
+    selectWindowKernel(original);
+
+    // a cutoff may end the sum early, but only once it is reached
+    vector<string> group(texts.begin(), texts.begin() + 12);
+    vector<PackedSequence> packed;
+    for (const auto& text : group) {
+        packed.push_back(encodeSequence(text));
+    }
+    for (int t = 0; t < 50; ++t) {
+        string kmer = randomSequence(gen, 1, 0);
+        int expected = bruteTotal(kmer, group);
+        int cutoff = gen() % (expected + 2);
+        int got = distanceTotal(encodeKmer(kmer, 1), 1, packed, cutoff);
+        if (expected < cutoff ? got != expected : got < cutoff) {
+            fail("distanceTotal cutoff " + to_string(cutoff) + ": " + to_string(got) + " for " + to_string(expected));
+        }
+    }
+}
+
+
+struct Dataset {
+    string name;
+    vector<string> texts;
+    vector<PackedSequence> sequences;
+};
+
+Dataset makeDataset(const string& name, const vector<string>& texts) {
+    Dataset data{name, texts, {}};
+    for (const auto& text : texts) {
+        data.sequences.push_back(encodeSequence(text));
+    }
+    return data;
+}
+
+vector<Dataset> engineDatasets() {
+    mt19937 gen(30);
+    vector<Dataset> datasets;
+    for (int d = 0; d < 6; ++d) {
+        vector<string> texts;
+        size_t count = 2 + d % 5;
+        for (size_t s = 0; s < count; ++s) {
+            texts.push_back(randomSequence(gen, 12 + gen() % 80, d % 2 ? 0.05 : 0));
+        }
+        datasets.push_back(makeDataset("random" + to_string(d), texts));
+    }
+    // a motif planted with a few changes in every sequence, so the optimum is far below the
+    // typical k-mer and the bounds prune hard
+    string motif = randomSequence(gen, 8, 0);
+    vector<string> texts;
+    for (int s = 0; s < 6; ++s) {
+        string copy = motif;
+        copy[gen() % copy.size()] = "ACGT"[gen() & 3];
+        texts.push_back(randomSequence(gen, gen() % 40, 0) + copy + randomSequence(gen, gen() % 40, 0));
+    }
+    datasets.push_back(makeDataset("planted", texts));
+    return datasets;
+}
+
+
+// a search result must be the optimum, and the k-mer returned must have that distance
+void checkResult(const string& what, const Dataset& data, int K, uint64_t kmer, int distance, int expected) {
+    if (distance != expected) {
+        fail(what + ": distance " + to_string(distance) + " instead of " + to_string(expected));
+        return;
+    }
+    int actual = bruteTotal(decodeKmer(kmer, K), data.texts);
+    if (actual != distance) {
+        fail(what + ": returned " + decodeKmer(kmer, K) + " is at " + to_string(actual) + ", not " + to_string(distance));
+    }
+}
+
+
+void checkEngines() {
+    vector<SearchSettings> variants;
+    for (string engine : {"bnb", "bestfirst", "portfolio", "bitslice"}) {
+        for (int tail : {-1, 0, 2}) {
+            for (string bounds : {"prefix", "table,lookahead"}) {
+                for (string order : {"best", "fixed", "frequency"}) {
+                    SearchSettings settings;
+                    settings.engine = engine;
+                    settings.tailLength = tail;
+                    settings.bounds = bounds;
+                    settings.order = order;
+                    settings.threads = engine == "portfolio" ? 3 : 1;
+                    variants.push_back(settings);
+                    if (engine == "bnb") {
+                        settings.threads = 3;
+                        variants.push_back(settings);
+                        settings.threads = 1;
+                        settings.adaptiveOrder = false;
+                        variants.push_back(settings);
+                    }
+                }
+            }
+        }
+    }
+
+    mt19937 gen(40);
+    for (const auto& data : engineDatasets()) {
+        size_t shortest = data.texts.front().size();
+        for (const auto& text : data.texts) {
+            shortest = min(shortest, text.size());
+        }
+        for (int K = 1; K <= 8 && static_cast<size_t>(K) <= shortest; ++K) {
+            string at = data.name + " K=" + to_string(K);
+            uint64_t reference = 0;
+            int expected = INT_MAX;
+            gray_code_search(buildWindowIndex(data.sequences, K), reference, expected);
+            checkResult("gray " + at, data, K, reference, expected, bruteTotal(decodeKmer(reference, K), data.texts));
+
+            uint64_t kmer = 0;
+            int distance = INT_MAX;
+            hypercube_search(data.sequences, kmer, distance, K);
+            checkResult("hypercube " + at, data, K, kmer, distance, expected);
+
+            string seed = randomSequence(gen, K, 0);
+            for (const auto& settings : variants) {
+                string what = settings.engine + " threads=" + to_string(settings.threads) + " tail=" + to_string(settings.tailLength)
+                              + " bounds=" + settings.bounds + " order=" + settings.order
+                              + (settings.adaptiveOrder ? "" : " input-order") + " " + at;
+                WindowIndex index = buildSearchIndex(data.sequences, K, settings);
+                unique_ptr<BoundSet> bounds = makeBoundSet(settings.bounds, index);
+                kmer = 0;
+                distance = INT_MAX;
+                runSearch(index, kmer, distance, settings, bounds.get());
+                checkResult(what, data, K, kmer, distance, expected);
+
+                // a floor at the optimum may end the search early, never above it
+                kmer = 0;
+                distance = INT_MAX;
+                runSearch(index, kmer, distance, settings, bounds.get(), expected);
+                checkResult(what + " floored", data, K, kmer, distance, expected);
+
+                // a seeded, polished start as batch mode and main use it
+                kmer = encodeKmer(seed, K);
+                distance = bruteTotal(seed, data.texts);
+                solveMedian(data.sequences, K, settings, kmer, distance);
+                checkResult(what + " seeded", data, K, kmer, distance, expected);
+            }
+
+            // an open list too small for the tree sends children down depth-first
+            WindowIndex index = buildSearchIndex(data.sequences, K, SearchSettings());
+            kmer = 0;
+            distance = INT_MAX;
+            best_first_search(index, kmer, distance, 4 * 32);
+            checkResult("bestfirst tiny queue " + at, data, K, kmer, distance, expected);
+
+            // every tail length the solve is instantiated for
+            for (int tail = 1; tail < K; ++tail) {
+                SearchSettings settings;
+                settings.tailLength = tail;
+                index = buildSearchIndex(data.sequences, K, settings);
+                kmer = 0;
+                distance = INT_MAX;
+                branch_and_bound(index, kmer, distance);
+                checkResult("bnb tail=" + to_string(tail) + " " + at, data, K, kmer, distance, expected);
+            }
+        }
+    }
+}
+
+
+#ifdef MEDIAN_STATS
+// nodes per depth and windows scanned of the last search in the stats report
+void lastSearchCounts(vector<uint64_t>& nodes, uint64_t& windows) {
+    ostringstream json;
+    writeStatsJson(json);
+    string report = json.str();
+    size_t at = report.rfind("\"nodes_per_depth\": [");
+    istringstream list(report.substr(report.find('[', at) + 1));
+    nodes.clear();
+    uint64_t count;
+    char separator = ',';
+    while (separator == ',' && list >> count >> separator) {
+        nodes.push_back(count);
+    }
+    windows = stoull(report.substr(report.find(':', report.find("\"windows_scanned\"", at)) + 1));
+}
+#endif
+
+
+// the parallel split has to stay above the tail solve, or every task below it walks the tail
+// node by node. started at the optimum the incumbent never moves, so below the split the
+// tree is the same on any thread count
+void checkSplitDepth() {
+    mt19937 gen(50);
+    vector<PackedSequence> sequences;
+    for (int s = 0; s < 64; ++s) {
+        sequences.push_back(encodeSequence(randomSequence(gen, 1000, 0)));
+    }
+    int K = 10;
+    SearchSettings settings;
+    settings.tailLength = 7;
+    WindowIndex index = buildSearchIndex(sequences, K, settings);
+    unique_ptr<BoundSet> bounds = makeBoundSet(settings.bounds, index);
+    int levels = maxSplitDepth(index);
+    if (levels != K - index.tailLength || defaultSplitDepth(levels, 8) > levels) {
+        fail("split depth " + to_string(defaultSplitDepth(levels, 8)) + " below the tail solve at " + to_string(K - index.tailLength));
+    }
+
+    uint64_t kmer = 0;
+    int optimum = INT_MAX;
+    runSearch(index, kmer, optimum, settings, bounds.get());
+    STATS_ONLY(vector<vector<uint64_t>> nodes(2);)
+    STATS_ONLY(uint64_t windows[2] = {};)
+    int threads[2] = {1, 8};
+    for (int run = 0; run < 2; ++run) {
+        settings.threads = threads[run];
+        // deeper than allowed on purpose: it must be clamped
+        settings.splitDepth = K;
+        int distance = optimum;
+        runSearch(index, kmer, distance, settings, bounds.get());
+        if (distance != optimum) {
+            fail("threads=" + to_string(threads[run]) + " from the optimum: " + to_string(distance) + " instead of " + to_string(optimum));
+        }
+        STATS_ONLY(lastSearchCounts(nodes[run], windows[run]);)
+    }
+#ifdef MEDIAN_STATS
+    // replayed task prefixes count again at the split depth and above, and rescan their windows
+    int split = levels;
+    for (int d = split + 1; d <= K; ++d) {
+        if (nodes[0][d] != nodes[1][d]) {
+            fail("depth " + to_string(d) + ": " + to_string(nodes[1][d]) + " nodes on 8 threads, " + to_string(nodes[0][d]) + " on 1");
+        }
+    }
+    if (windows[1] > 2 * windows[0]) {
+        fail(to_string(windows[1]) + " windows scanned on 8 threads, " + to_string(windows[0]) + " on 1");
+    }
+#endif
+}
+
+
+// the summary of text at K by brute force: every window, N read as A and flagged
+KmerSummary bruteSummary(const string& text, int K) {
+    KmerSummary summary;
+    summary.K = K;
+    summary.length = text.size();
+    summary.presence.assign(((1ULL << (2 * K)) + 63) / 64, 0);
+    for (size_t p = 0; p + K <= text.size(); ++p) {
+        uint64_t kmer = 0;
+        uint64_t invalid = 0;
+        for (int j = 0; j < K; ++j) {
+            int code = encodeNT(text[p + j]);
+            if (code < 0) {
+                invalid |= 1ULL << (2 * j);
+            } else {
+                kmer |= static_cast<uint64_t>(code) << (2 * j);
+            }
+        }
+        if (invalid) {
+            summary.invalidWindows.push_back({kmer, invalid});
+        } else {
+            summary.presence[kmer >> 6] |= 1ULL << (kmer & 63);
+        }
+    }
+    return summary;
+}
+
+void expectSummary(const string& what, KmerSummary got, KmerSummary expected) {
+    // the invalid windows are a set; their order is the order they were met in
+    for (auto* summary : {&got, &expected}) {
+        auto& windows = summary->invalidWindows;
+        sort(windows.begin(), windows.end());
+        windows.erase(unique(windows.begin(), windows.end()), windows.end());
+    }
+    if (got.K != expected.K || got.length != expected.length || got.presence != expected.presence
+        || got.invalidWindows != expected.invalidWindows) {
+        fail(what + ": summary differs from the windows of the sequence");
+    }
+}
+
+
+// streamed input: summaries built from the packed sequence, from pieces of text and from a
+// streamed file all hold exactly the windows, and every engine that runs on summaries finds
+// the same median as on the sequences
+void checkStreaming() {
+    mt19937 gen(60);
+    for (const auto& data : engineDatasets()) {
+        size_t shortest = data.texts.front().size();
+        for (const auto& text : data.texts) {
+            shortest = min(shortest, text.size());
+        }
+        // the dataset as a CRLF file, between records without sequence the stream skips
+        string fasta = ">empty\r\n";
+        for (const auto& text : data.texts) {
+            fasta += ">seq\r\n" + text.substr(0, text.size() / 2) + "\r\n" + text.substr(text.size() / 2) + "\n";
+        }
+        string path = writeTempFile(fasta + ">blank\n\n");
+
+        for (int K = 1; K <= 8 && static_cast<size_t>(K) <= shortest; ++K) {
+            string at = data.name + " K=" + to_string(K);
+            vector<KmerSummary> summaries;
+            for (size_t s = 0; s < data.texts.size(); ++s) {
+                const string& text = data.texts[s];
+                KmerSummary expected = bruteSummary(text, K);
+                summaries.push_back(summarizeSequence(data.sequences[s], K));
+                expectSummary("summarizeSequence " + at, summaries.back(), expected);
+                SummaryBuilder builder(K);
+                for (size_t p = 0; p < text.size();) {
+                    size_t n = min<size_t>(text.size() - p, gen() % 8);
+                    builder.append(text.data() + p, n);
+                    p += n;
+                }
+                expectSummary("SummaryBuilder " + at, builder.finish(), expected);
+            }
+            size_t streamed = 0;
+            summarizeFasta(path, K, [&](KmerSummary&& summary) {
+                if (streamed < data.texts.size()) {
+                    expectSummary("summarizeFasta " + at, summary, bruteSummary(data.texts[streamed], K));
+                }
+                streamed++;
+            });
+            if (streamed != data.texts.size()) {
+                fail("summarizeFasta " + at + ": " + to_string(streamed) + " records for " + to_string(data.texts.size()));
+            }
+
+            uint64_t reference = 0;
+            int expected = INT_MAX;
+            gray_code_search(buildWindowIndex(data.sequences, K), reference, expected);
+
+            uint64_t kmer = 0;
+            int distance = INT_MAX;
+            gray_code_search(buildWindowIndex(summaries), kmer, distance);
+            checkResult("streamed gray " + at, data, K, kmer, distance, expected);
+
+            vector<uint16_t> landscape(1ULL << (2 * K), 0);
+            for (const auto& summary : summaries) {
+                addToLandscape(landscape, summary);
+            }
+            kmer = 0;
+            distance = INT_MAX;
+            bestInLandscape(landscape, K, kmer, distance);
+            checkResult("streamed hypercube " + at, data, K, kmer, distance, expected);
+
+            // indexed one record at a time, as the streamed run does
+            WindowIndex appended;
+            for (const auto& summary : summaries) {
+                appendToWindowIndex(appended, summary);
+            }
+            for (string engine : {"bnb", "bestfirst", "bitslice"}) {
+                SearchSettings settings;
+                settings.engine = engine;
+                settings.bounds = "table,lookahead";
+                WindowIndex index = appended;
+                prepareSearchIndex(index, settings);
+                unique_ptr<BoundSet> bounds = makeBoundSet(settings.bounds, index);
+                kmer = 0;
+                distance = INT_MAX;
+                runSearch(index, kmer, distance, settings, bounds.get());
+                checkResult("streamed " + engine + " " + at, data, K, kmer, distance, expected);
+            }
+        }
+        remove(path.c_str());
+    }
+}
+
+
+// the suffix tail table against gray_code_search on each suffix index: transforms up to
+// TRANSFORM_TAIL_L, branch and bound past it, and the carried values beyond maxExact
+void checkTailTable() {
+    mt19937 gen(70);
+    int K = 11;
+    for (int d = 0; d < 3; ++d) {
+        vector<string> texts;
+        // the last one shares a motif with a change or two per sequence, so long tails are close
+        string motif = randomSequence(gen, K, 0);
+        for (int s = 0; s < 4; ++s) {
+            string text = randomSequence(gen, 20 + gen() % 30, d == 1 ? 0.05 : 0);
+            if (d == 2) {
+                string copy = motif;
+                copy[gen() % K] = "ACGT"[gen() & 3];
+                text.insert(gen() % text.size(), copy);
+            }
+            texts.push_back(text);
+        }
+        Dataset data = makeDataset("tails" + to_string(d), texts);
+        WindowIndex index = buildWindowIndex(data.sequences, K);
+        vector<int> exact = suffixTailTable(index, K - 1);
+        vector<int> carried = suffixTailTable(index, TRANSFORM_TAIL_L);
+        for (int L = 1; L < K; ++L) {
+            uint64_t kmer = 0;
+            int expected = INT_MAX;
+            gray_code_search(suffixWindowIndex(index, L), kmer, expected);
+            string at = data.name + " L=" + to_string(L);
+            if (exact[L] != expected) {
+                fail("tail table " + at + ": " + to_string(exact[L]) + " instead of " + to_string(expected));
+            }
+            int kept = L <= TRANSFORM_TAIL_L ? expected : exact[TRANSFORM_TAIL_L];
+            if (carried[L] != kept) {
+                fail("carried tail table " + at + ": " + to_string(carried[L]) + " instead of " + to_string(kept));
+            }
+        }
+        if (exact[K] != exact[K - 1] || carried[K] != carried[TRANSFORM_TAIL_L]) {
+            fail("tail table " + data.name + ": the whole length is not carried");
+        }
+    }
+}
+
+
+// batch mode seeds each K from the K-1 median and takes the K-1 optimum as a floor, so a
+// wrong seed or floor shows up as a wrong row. lengths that are not consecutive run
+// unseeded; unreadable files and too long k-mers fail their jobs
+void checkBatch() {
+    vector<Dataset> datasets = engineDatasets();
+    vector<string> paths;
+    for (const auto& data : datasets) {
+        string fasta;
+        for (const auto& text : data.texts) {
+            fasta += ">" + data.name + "\n" + text + "\n";
+        }
+        paths.push_back(writeTempFile(fasta));
+    }
+    vector<BatchJob> jobs;
+    for (const auto& path : paths) {
+        jobs.push_back({path, {1, 2, 3, 4, 5, 6}});
+        jobs.push_back({path, {2, 4, 5}});
+    }
+    jobs.push_back({"/nonexistent/median_batch.fasta", {3, 4}});
+    size_t shortest = datasets.front().texts.front().size();
+    for (const auto& text : datasets.front().texts) {
+        shortest = min(shortest, text.size());
+    }
+    jobs.push_back({paths.front(), {static_cast<int>(shortest) + 1}});
+
+    for (string engine : {"bnb", "bestfirst", "portfolio", "bitslice", "auto"}) {
+        SearchSettings settings;
+        settings.engine = engine;
+        settings.threads = engine == "portfolio" ? 2 : 1;
+        ostringstream out;
+        // the failing jobs report to cerr; those messages are expected here
+        ostringstream errors;
+        streambuf* console = cerr.rdbuf(errors.rdbuf());
+        int failed = runBatch(jobs, settings, out);
+        cerr.rdbuf(console);
+        if (failed != 3) {
+            fail("batch " + engine + ": " + to_string(failed) + " failed jobs instead of 3");
+        }
+
+        istringstream rows(out.str());
+        string row;
+        getline(rows, row);
+        size_t count = 0;
+        while (getline(rows, row)) {
+            istringstream fields(row);
+            string path;
+            string ran;
+            string median;
+            int K = 0;
+            int distance = 0;
+            fields >> path >> K >> ran >> median >> distance;
+            size_t d = find(paths.begin(), paths.end(), path) - paths.begin();
+            if (d == paths.size()) {
+                fail("batch " + engine + ": row for an unknown file: " + row);
+                continue;
+            }
+            const Dataset& data = datasets[d];
+            uint64_t reference = 0;
+            int expected = INT_MAX;
+            gray_code_search(buildWindowIndex(data.sequences, K), reference, expected);
+            checkResult("batch " + engine + " " + data.name + " K=" + to_string(K), data, K, encodeKmer(median, K), distance,
+                        expected);
+            count++;
+        }
+        if (count != 9 * paths.size()) {
+            fail("batch " + engine + ": " + to_string(count) + " rows instead of " + to_string(9 * paths.size()));
+        }
+    }
+    for (const auto& path : paths) {
+        remove(path.c_str());
+    }
+}
+
+
+int main() {
+    checkKernels();
+    checkEngines();
+    checkStreaming();
+    checkBatch();
+    checkTailTable();
+    checkSplitDepth();
+    if (failures) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "all checks passed" << endl;
+    return 0;
+}
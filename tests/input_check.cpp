@@ -0,0 +1,242 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "src/packed_sequence.h"
+#include "src/fasta_loader.h"
+#include "src/batch.h"
+
+using namespace std;
+
+
+// checks of the input readers against hand-written expectations: the mapped, parsed and
+// streamed fasta paths on line endings, non-ACGT characters and records without sequence,
+// and the k-mer length specs and manifests of batch mode. prints each mismatch and exits 1
+// if there was any
+
+
+int failures = 0;
+
+void fail(const string& what) {
+    if (++failures <= 20) {
+        cerr << "FAIL: " << what << endl;
+    }
+}
+
+
+// contents in a fresh temporary file; the caller removes it
+string writeTempFile(const string& contents) {
+    char path[] = "/tmp/median_input_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        throw runtime_error("could not create a temporary file");
+    }
+    close(fd);
+    ofstream(path, ios::binary) << contents;
+    return path;
+}
+
+// the sequence as text, N for every non-ACGT position
+string decodeSequence(const PackedSequence& seq) {
+    string text(seq.length, 'N');
+    for (size_t i = 0; i < seq.length; ++i) {
+        int code = ntCodeOrInvalid(seq, i);
+        if (code >= 0) {
+            text[i] = "ACGT"[code];
+        }
+    }
+    return text;
+}
+
+
+struct Records {
+    vector<string> names;
+    vector<string> sequences;
+};
+
+Records fromFasta(const FastaFile& fasta) {
+    Records records{fasta.names, {}};
+    for (const auto& seq : fasta.sequences) {
+        records.sequences.push_back(decodeSequence(seq));
+    }
+    return records;
+}
+
+// what streamFasta hands over, with records without sequence dropped as loadFasta does
+class RecordSink : public FastaSink {
+public:
+    Records records;
+
+    void beginRecord(const string& name) override {
+        current = name;
+        text.clear();
+    }
+    void appendSequence(const char* data, size_t n) override { text.append(data, n); }
+    void endRecord() override {
+        if (text.empty()) {
+            return;
+        }
+        records.names.push_back(current);
+        PackedSequence seq = encodeSequence(text);
+        records.sequences.push_back(decodeSequence(seq));
+    }
+
+private:
+    string current;
+    string text;
+};
+
+
+void expectRecords(const string& what, const Records& got, const Records& expected) {
+    if (got.names != expected.names || got.sequences != expected.sequences) {
+        string listed;
+        for (size_t i = 0; i < got.names.size(); ++i) {
+            listed += " >" + got.names[i] + " " + (i < got.sequences.size() ? got.sequences[i] : "?");
+        }
+        if (listed.size() > 120) {
+            listed = listed.substr(0, 120) + "...";
+        }
+        fail(what + ": got" + (listed.empty() ? " nothing" : listed));
+    }
+}
+
+
+// the same text through parseFasta, loadFasta and streamFasta
+void checkFasta(const string& name, const string& text, const Records& expected) {
+    expectRecords(name + " parsed", fromFasta(parseFasta(text.data(), text.size())), expected);
+    string path = writeTempFile(text);
+    try {
+        expectRecords(name + " loaded", fromFasta(loadFasta(path)), expected);
+        RecordSink sink;
+        streamFasta(path, sink);
+        expectRecords(name + " streamed", sink.records, expected);
+    } catch (const exception& e) {
+        fail(name + ": " + e.what());
+    }
+    remove(path.c_str());
+}
+
+
+void checkFastaFiles() {
+    checkFasta("lf", ">a\nACGT\nAC\n>b\nGG\n", {{"a", "b"}, {"ACGTAC", "GG"}});
+    checkFasta("crlf", ">a x\r\nAC\r\nGT\r\n>b\r\nT\r\n", {{"a x", "b"}, {"ACGT", "T"}});
+    checkFasta("non-ACGT", ">a\nACNRGT\nn-\n", {{"a"}, {"ACNNGTNN"}});
+    checkFasta("empty records", ">empty\n>a\nAC\n>blank\n\n\r\n>b\nG", {{"a", "b"}, {"AC", "G"}});
+    checkFasta("blank lines", ">a\nAC\n\nGT\n\n", {{"a"}, {"ACGT"}});
+    checkFasta("before header", "ACG\n>a\nT\n", {{"", "a"}, {"ACG", "T"}});
+    checkFasta("no input", "", {});
+    checkFasta("header only", ">only", {});
+    checkFasta("crlf header only", ">only\r\n", {});
+
+    // a record spanning many packed words, in lines that do not line up with them
+    mt19937 gen(10);
+    string sequence(1000, 'A');
+    for (auto& c : sequence) {
+        c = gen() % 20 ? "ACGT"[gen() & 3] : 'N';
+    }
+    string text = ">long\n";
+    for (size_t i = 0; i < sequence.size(); i += 61) {
+        text += sequence.substr(i, 61) + (i % 2 ? "\r\n" : "\n");
+    }
+    checkFasta("long", text, {{"long"}, {sequence}});
+
+    try {
+        loadFasta("/nonexistent/median_input.fasta");
+        fail("loadFasta of a missing file did not throw");
+    } catch (const runtime_error&) {
+    }
+}
+
+
+string listLengths(const vector<int>& lengths) {
+    string listed;
+    for (int K : lengths) {
+        listed += (listed.empty() ? "" : ",") + to_string(K);
+    }
+    return listed;
+}
+
+
+void checkBatchInput() {
+    vector<pair<string, vector<int>>> specs = {
+        {"8", {8}},
+        {"5-9", {5, 6, 7, 8, 9}},
+        {"5,7,10-12", {5, 7, 10, 11, 12}},
+        {"3,1-2,3", {1, 2, 3}},
+        {"32", {32}},
+    };
+    for (const auto& spec : specs) {
+        try {
+            vector<int> lengths = parseKmerSpec(spec.first);
+            if (lengths != spec.second) {
+                fail("k-mer spec '" + spec.first + "': " + listLengths(lengths));
+            }
+        } catch (const exception& e) {
+            fail("k-mer spec '" + spec.first + "': " + e.what());
+        }
+    }
+    for (string spec : {"", "0", "33", "5-3", "a", "4-", "-3", ",", "1,,2", "5x"}) {
+        try {
+            parseKmerSpec(spec);
+            fail("k-mer spec '" + spec + "' was accepted");
+        } catch (const invalid_argument&) {
+        }
+    }
+
+    string path = writeTempFile("# jobs\n\n  a.fa 3-4\nb.fa\n\tc.fa 7 extra\n#d.fa 5\n");
+    try {
+        vector<BatchJob> jobs = readManifest(path, {5});
+        string listed;
+        for (const auto& job : jobs) {
+            listed += " " + job.path + ":" + listLengths(job.kmerLengths);
+        }
+        if (listed != " a.fa:3,4 b.fa:5 c.fa:7") {
+            fail("manifest:" + listed);
+        }
+    } catch (const exception& e) {
+        fail(string("manifest: ") + e.what());
+    }
+    try {
+        // a line without a spec needs default lengths
+        readManifest(path, {});
+        fail("manifest line without k-mer lengths was accepted");
+    } catch (const runtime_error&) {
+    }
+    remove(path.c_str());
+
+    path = writeTempFile("a.fa 4\nb.fa 0\n");
+    try {
+        readManifest(path, {5});
+        fail("manifest with a bad spec was accepted");
+    } catch (const runtime_error& e) {
+        if (string(e.what()).find(":2:") == string::npos) {
+            fail(string("manifest error without its line: ") + e.what());
+        }
+    }
+    remove(path.c_str());
+
+    try {
+        readManifest("/nonexistent/manifest.txt", {5});
+        fail("missing manifest was accepted");
+    } catch (const runtime_error&) {
+    }
+}
+
+
+int main() {
+    checkFastaFiles();
+    checkBatchInput();
+    if (failures) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "all checks passed" << endl;
+    return 0;
+}